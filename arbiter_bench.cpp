@@ -0,0 +1,125 @@
+#include "arc_cache.hpp"
+#include "cache_arbiter.hpp"
+#include "workload.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Many tenants, each with its own ARC, under one total capacity: split evenly and left alone,
+// versus rebalanced by CacheArbiter every --period accesses. Tenants cycle through four
+// workloads with different miss-ratio curves, and the busier ones get more of the accesses.
+
+struct Tenant {
+    std::string kind;
+    std::vector<int> keys;
+    size_t next = 0;
+};
+
+template<typename Pattern>
+std::vector<int> materialize(Pattern pattern, size_t length) {
+    auto source = make_stream(std::move(pattern), length);
+    return read_all(source);
+}
+
+std::vector<Tenant> make_tenants(size_t count, size_t length, std::vector<size_t>& schedule) {
+    std::vector<Tenant> tenants(count);
+    std::vector<size_t> rates(count);
+    size_t rate_sum = 0;
+    for (size_t t = 0; t < count; t++) {
+        rates[t] = size_t(1) << (t / 4 % 3); // 1, 2 or 4 accesses per round
+        rate_sum += rates[t];
+    }
+    for (size_t round = 0; round * rate_sum < length; round++) {
+        for (size_t t = 0; t < count; t++) {
+            for (size_t r = 0; r < rates[t]; r++) schedule.push_back(t);
+        }
+    }
+    for (size_t t = 0; t < count; t++) {
+        size_t n = schedule.size() / rate_sum * rates[t];
+        switch (t % 4) {
+        case 0:
+            tenants[t].kind = "Zipf(1.0) 20k";
+            tenants[t].keys = materialize(ZipfianPattern(20000, 1.0, t), n);
+            break;
+        case 1:
+            tenants[t].kind = "Random 200k";
+            tenants[t].keys = materialize(RandomPattern(200000, t), n);
+            break;
+        case 2:
+            tenants[t].kind = "Zipf(0.7) 100k";
+            tenants[t].keys = materialize(ZipfianPattern(100000, 0.7, t), n);
+            break;
+        default:
+            tenants[t].kind = "Loop 1500";
+            tenants[t].keys = materialize(PeriodicPattern(1500, 1500), n);
+            break;
+        }
+    }
+    return tenants;
+}
+
+int main(int argc, char** argv) {
+    size_t tenant_count = 40;
+    size_t capacity = 40 * 2000; // total, over all tenants
+    size_t pattern_length = 8000000;
+    size_t period = 100000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--tenants") == 0 && i + 1 < argc) {
+            tenant_count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            capacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--length") == 0 && i + 1 < argc) {
+            pattern_length = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--period") == 0 && i + 1 < argc) {
+            period = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    std::vector<size_t> schedule;
+    std::vector<Tenant> tenants = make_tenants(tenant_count, pattern_length, schedule);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << tenant_count << " tenants, " << capacity << " entries in total, " << schedule.size()
+              << " accesses, rebalanced every " << period << "\n";
+    std::cout << "Split\t\tHit Rate (%)\tLast half (%)\n";
+    for (bool arbitrated : {false, true}) {
+        for (Tenant& tenant : tenants) tenant.next = 0;
+        std::vector<std::unique_ptr<ARCache<int, int>>> caches;
+        CacheArbiter arbiter;
+        for (size_t t = 0; t < tenant_count; t++) {
+            caches.push_back(std::make_unique<ARCache<int, int>>(capacity / tenant_count));
+            arbiter.add(*caches.back(), capacity / tenant_count);
+        }
+
+        uint64_t hits = 0, late_hits = 0;
+        for (size_t i = 0; i < schedule.size(); i++) {
+            Tenant& tenant = tenants[schedule[i]];
+            ARCache<int, int>& cache = *caches[schedule[i]];
+            int key = tenant.keys[tenant.next++];
+            if (arbitrated) arbiter.record(schedule[i], key);
+            int value;
+            if (cache.get(key, value)) {
+                hits++;
+                if (i >= schedule.size() / 2) late_hits++;
+            } else {
+                cache.put(key, key);
+            }
+            if (arbitrated && (i + 1) % period == 0) arbiter.rebalance();
+        }
+        std::cout << (arbitrated ? "Arbitrated" : "Even") << "\t\t" << 100.0 * hits / schedule.size() << "%\t\t"
+                  << 100.0 * late_hits / (schedule.size() - schedule.size() / 2) << "%\n";
+
+        if (arbitrated) {
+            std::cout << "\nFinal capacity by tenant (total " << capacity << "):\nTenant\tWorkload\tRate\tCapacity\n";
+            for (size_t t = 0; t < tenant_count; t++) {
+                std::cout << t << "\t" << tenants[t].kind << "\t" << (size_t(1) << (t / 4 % 3)) << "\t"
+                          << arbiter.capacity(t) << "\n";
+            }
+        }
+    }
+    return 0;
+}
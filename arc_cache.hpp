@@ -2,43 +2,242 @@
 #define ARC_CACHE_HPP
 
 #include "cache.hpp"
+#include "scan_detector.hpp"
 #include <unordered_map>
 #include <list>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// How ARCache::put treats a cold miss that the scan detector attributes to a sequential scan
+enum class ScanPolicy
+{
+    None,       // no detection, every miss is admitted at the MRU end of T1
+    Bypass,     // scan keys are not admitted at all
+    InsertAtLRU // scan keys are admitted at the LRU end of T1, so they are evicted first
+};
+
+// Counters exposed through ARCache::stats()
+struct ARCStats
+{
+    uint64_t scan_misses = 0; // cold misses detected as part of a scan
+};
 
 template <typename K, typename V>
-class ARCache : public Cache<K, V>
+class ARCache final : public Cache<K, V>
 {
+public:
+    // Called with each resident entry that replacement pushes out of T1/T2 (not for erase() or clear())
+    using EvictionCallback = std::function<void(const K &, const V &)>;
+    using Tag = uint32_t;
+
 private:
+    using KeyList = std::list<K, CountingAllocator<K>>;
+    template <typename T>
+    using Map = std::unordered_map<K, T, std::hash<K>, std::equal_to<K>, CountingAllocator<std::pair<const K, T>>>;
+
+    // The tag of an entry stored with put_tagged(), its version then, and the entry's node in
+    // the tag's key list (or, once the tag is invalidated, in the stale list)
+    struct TaggedVersion
+    {
+        Tag tag;
+        uint64_t version;
+        typename KeyList::iterator pos;
+    };
+
+    struct TagState
+    {
+        uint64_t version;
+        KeyList keys; // resident entries stored under this version
+    };
+    using TagMap = std::unordered_map<Tag, TagState>;
+
+    // Nodes freed per put()/get() while earlier generations are still being reclaimed
+    static const size_t RECLAIM_STEP = 16;
+
+    // The containers of a generation retired by clear(), freed a few nodes at a time. They
+    // keep reporting to the cache's memory counters until they are gone.
+    struct Retired
+    {
+        KeyList t1, t2, b1, b2;
+        Map<std::pair<V, typename KeyList::iterator>> t1_map, t2_map;
+        Map<typename KeyList::iterator> b1_map, b2_map;
+        Map<TaggedVersion> entry_tags;
+        TagMap tags;
+        KeyList stale;
+
+        Retired(MemoryCounter *entries, MemoryCounter *index, MemoryCounter *ghosts)
+            : t1(CountingAllocator<K>(index)), t2(CountingAllocator<K>(index)),
+              b1(CountingAllocator<K>(ghosts)), b2(CountingAllocator<K>(ghosts)),
+              t1_map(CountingAllocator<K>(entries)), t2_map(CountingAllocator<K>(entries)),
+              b1_map(CountingAllocator<K>(ghosts)), b2_map(CountingAllocator<K>(ghosts)),
+              entry_tags(CountingAllocator<K>(entries)), stale(CountingAllocator<K>(entries)) {}
+
+        // Frees up to budget nodes and returns how many it freed
+        size_t free_some(size_t budget)
+        {
+            size_t freed = 0;
+            for (KeyList *list : {&t1, &t2, &b1, &b2, &stale})
+            {
+                for (; freed < budget && !list->empty(); freed++)
+                {
+                    list->pop_back();
+                }
+            }
+            freed += drain(t1_map, budget - freed);
+            freed += drain(t2_map, budget - freed);
+            freed += drain(b1_map, budget - freed);
+            freed += drain(b2_map, budget - freed);
+            freed += drain(entry_tags, budget - freed);
+            while (freed < budget && !tags.empty())
+            {
+                KeyList &keys = tags.begin()->second.keys;
+                for (; freed < budget && !keys.empty(); freed++)
+                {
+                    keys.pop_back();
+                }
+                if (keys.empty())
+                {
+                    tags.erase(tags.begin());
+                    freed++;
+                }
+            }
+            return freed;
+        }
+
+        template <typename M>
+        static size_t drain(M &map, size_t budget)
+        {
+            if (map.empty())
+            {
+                return 0;
+            }
+            size_t freed = 0;
+            for (; freed < budget && !map.empty(); freed++)
+            {
+                map.erase(map.begin());
+            }
+            if (map.empty())
+            {
+                map.rehash(0); // drops the bucket array without clearing it first, as destruction would
+            }
+            return freed;
+        }
+
+        bool empty() const
+        {
+            return t1.empty() && t2.empty() && b1.empty() && b2.empty() && t1_map.empty() && t2_map.empty() &&
+                   b1_map.empty() && b2_map.empty() && entry_tags.empty() && tags.empty() && stale.empty();
+        }
+    };
+
     size_t capacity; // Maximum number of items in cache
     size_t p;        // Target size for T1
+    IndexMode index_mode;
+    bool over_capacity = false; // resize() lowered the capacity and the surplus is not gone yet
+
+    ScanPolicy scan_policy;
+    ScanDetector<K> scan_detector;
+    ARCStats counters;
+    EvictionCallback on_evict;
+
+    // Resident values are counted as entries, the T1/T2 recency lists as index, and B1/B2 as ghosts
+    MemoryCounter entry_bytes; // declared before the containers that report to them
+    MemoryCounter index_bytes;
+    MemoryCounter ghost_bytes;
 
     // T1: Recent items
-    std::list<K> t1;                                                             // Most recently used items
-    std::unordered_map<K, std::pair<V, typename std::list<K>::iterator>> t1_map; // t1_map is a Hashing table. Key is K type, value is a std::pair type including a value V and a container pointing to the position in std::list<K>. Key to value and postion in t1
+    KeyList t1;                                                    // Most recently used items
+    Map<std::pair<V, typename KeyList::iterator>> t1_map; // t1_map is a Hashing table. Key is K type, value is a std::pair type including a value V and a container pointing to the position in std::list<K>. Key to value and postion in t1
 
     // T2: Frequent items
-    std::list<K> t2; // Most frequently used items
-    std::unordered_map<K, std::pair<V, typename std::list<K>::iterator>> t2_map;
+    KeyList t2; // Most frequently used items
+    Map<std::pair<V, typename KeyList::iterator>> t2_map;
 
     // B1: Ghost entries for recently evicted from T1
-    std::list<K> b1;
-    std::unordered_map<K, typename std::list<K>::iterator> b1_map;
+    KeyList b1;
+    Map<typename KeyList::iterator> b1_map;
 
     // B2: Ghost entries for recently evicted from T2
-    std::list<K> b2;
-    std::unordered_map<K, typename std::list<K>::iterator> b2_map;
+    KeyList b2;
+    Map<typename KeyList::iterator> b2_map;
+
+    // Tags of the resident entries stored with put_tagged(); an entry is stale once the
+    // version of its tag has moved past the one recorded here. invalidate_tag() splices the
+    // tag's key list onto stale, which replacement empties before it evicts a live entry.
+    Map<TaggedVersion> entry_tags;
+    TagMap tags;
+    KeyList stale;
+
+    uint64_t current_generation = 0;
+    std::vector<std::unique_ptr<Retired>> retired;
+
+    void untag(const K &key)
+    {
+        if (entry_tags.empty())
+        {
+            return;
+        }
+        auto it = entry_tags.find(key);
+        if (it == entry_tags.end())
+        {
+            return;
+        }
+        TagState &state = tags.find(it->second.tag)->second;
+        (state.version == it->second.version ? state.keys : stale).erase(it->second.pos);
+        entry_tags.erase(it);
+    }
+
+    bool is_stale(const K &key) const
+    {
+        auto it = entry_tags.find(key);
+        return it != entry_tags.end() && tags.find(it->second.tag)->second.version != it->second.version;
+    }
+
+    // Erases the oldest invalidated entry without a ghost entry or the eviction callback;
+    // returns false if there is none
+    bool drop_stale()
+    {
+        if (stale.empty())
+        {
+            return false;
+        }
+        K key = stale.front();
+        erase(key);
+        return true;
+    }
+
+    // Drops key, without a ghost entry, if its tag has been invalidated
+    void expire_if_stale(const K &key)
+    {
+        if (!entry_tags.empty() && is_stale(key))
+        {
+            erase(key);
+        }
+    }
 
     void replace(bool in_b2)
     { // whether replacement is in b2 ；in_b2 表示导致缓存未命中的页面是否存在于 B2 中
-        if (!t1.empty() && ((t1.size() > p) || (in_b2 && t1.size() == p)))
+        if (drop_stale())
+        {
+            return; // an invalidated entry frees the slot instead of a live one
+        }
+        if (!t1.empty() && ((t1.size() > p) || (in_b2 && t1.size() == p) || t2.empty()))
         {                          // Delete the LRU in T1 and move it to MRU in B1
             K lru_key = t1.back(); // delete the last element in t1(LRU)
             t1.pop_back();         // O(1),delete the element at the end;  erase is O(n)
-            V val = t1_map[lru_key].first;
+            V val = std::move(t1_map[lru_key].first);
             t1_map.erase(lru_key);
+            untag(lru_key);
 
             b1.push_front(lru_key); // insert in the beginning of b1
             b1_map[lru_key] = b1.begin();
+            if (on_evict)
+            {
+                on_evict(lru_key, val);
+            }
 
             /*   if (b1.size() > capacity) { //if the size of b1 is larger than the size of cache
                    K ghost_key = b1.back();
@@ -51,8 +250,9 @@ private:
             K lru_key = t2.back();
             // LRU key in t2
             t2.pop_back();
-            V val = t2_map[lru_key].first;
+            V val = std::move(t2_map[lru_key].first);
             t2_map.erase(lru_key);
+            untag(lru_key);
 
             b2.push_front(lru_key);
             b2_map[lru_key] = b2.begin();
@@ -63,14 +263,108 @@ private:
                 b2.pop_back();
                 b2_map.erase(ghost_key);
             }
+            if (on_evict)
+            {
+                on_evict(lru_key, val);
+            }
         }
     }
 
-public:
-    explicit ARCache(size_t size) : capacity(size), p(0) {} // Constructor
+    // Frees a slot for a key that is in none of the four lists (Case 5 of put)
+    void make_room()
+    {
+        if (t1.size() + t2.size() >= capacity && drop_stale())
+        {
+            return;
+        }
+        if (t1.size() + t2.size() < capacity)
+        {
+            // Not full, though the directory may be (after resize() grew the cache, or after
+            // erase()): keep it within its bounds by forgetting ghosts instead of evicting
+            if (t1.size() + b1.size() >= capacity && !b1.empty())
+            {
+                b1_map.erase(b1.back());
+                b1.pop_back();
+            }
+            else if (t1.size() + t2.size() + b1.size() + b2.size() >= 2 * capacity)
+            {
+                KeyList &ghosts = b2.empty() ? b1 : b2;
+                (&ghosts == &b1 ? b1_map : b2_map).erase(ghosts.back());
+                ghosts.pop_back();
+            }
+            return;
+        }
+        if (t1.size() + b1.size() >= capacity)
+        {
+            if (t1.size() < capacity)
+            {
+                if (!b1.empty())
+                {
+                    K lru_key = b1.back();
+                    b1.pop_back();
+                    b1_map.erase(lru_key);
+                }
+                replace(false);
+            }
+            else
+            {
+                K lru_key = t1.back();
+                t1.pop_back();
+                auto victim = t1_map.find(lru_key);
+                V val = std::move(victim->second.first);
+                t1_map.erase(victim);
+                untag(lru_key);
+                if (on_evict)
+                {
+                    on_evict(lru_key, val);
+                }
+            }
+        }
+        else if (t1.size() + t2.size() + b1.size() + b2.size() >= capacity)
+        {
+            if (t1.size() + t2.size() + b1.size() + b2.size() == 2 * capacity)
+            {
+                if (!b2.empty())
+                {
+                    K lru_key = b2.back();
+                    b2.pop_back();
+                    b2_map.erase(lru_key);
+                }
+            }
+            replace(false);
+        }
+    }
 
-    void put(const K &key, const V &value) override
-    { // Put key-value pair in cache
+    // One step towards the bounds of a capacity lowered by resize(): evicts a resident entry
+    // (through replace(), so p decides the list) while more than capacity are resident, then
+    // drops old ghosts until T1 + B1 <= c and the whole directory <= 2c. Returns false once
+    // every bound holds.
+    bool shrink_step()
+    {
+        if (t1.size() + t2.size() > capacity)
+        {
+            replace(false);
+            return true;
+        }
+        if (t1.size() + b1.size() > capacity && !b1.empty())
+        {
+            b1_map.erase(b1.back());
+            b1.pop_back();
+            return true;
+        }
+        if (t1.size() + t2.size() + b1.size() + b2.size() > 2 * capacity)
+        {
+            KeyList &ghosts = b2.empty() ? b1 : b2;
+            (&ghosts == &b1 ? b1_map : b2_map).erase(ghosts.back());
+            ghosts.pop_back();
+            return true;
+        }
+        return false;
+    }
+
+    // The ARC logic of put(); get() promotes its hits through here, which keeps their tags
+    void store(const K &key, const V &value)
+    {
         // Case 1: Key exists in T1, Recent used items to be moved to front of T2
         if (t1_map.count(key))
         {                                      // check whether key is in t1_map
@@ -95,9 +389,12 @@ public:
         {
             double delta = std::max(1.0, static_cast<double>(b2.size()) / static_cast<double>(std::max(size_t(1), b1.size()))); // the ratio of b2 and b1, make sure that it is larger than 1
             p = std::min(capacity, static_cast<size_t>(p + delta));                                                             // make sure p is smaller than capacity
-            replace(false);                                                                                                     //?
-            b1.erase(b1_map[key]);
+            b1.erase(b1_map[key]); // before replace(), which may trim the ghost lists
             b1_map.erase(key);
+            if (t1.size() + t2.size() >= capacity)
+            {
+                replace(false);
+            }
             t2.push_front(key);
             t2_map[key] = {value, t2.begin()};
             return;
@@ -108,9 +405,12 @@ public:
         {
             double delta = std::max(1.0, static_cast<double>(b1.size()) / static_cast<double>(std::max(size_t(1), b2.size()))); // the ratio of b1 and b2
             p = std::max(size_t(0), static_cast<size_t>(p >= delta ? p - delta : 0));                                           // if p>=delta, p=p-delta,otherwise p=0 ; change the size of p according to the b1 and b2
-            replace(true);
-            b2.erase(b2_map[key]);
+            b2.erase(b2_map[key]); // before replace(), which may trim this very key out of B2
             b2_map.erase(key);
+            if (t1.size() + t2.size() >= capacity)
+            {
+                replace(true);
+            }
             t2.push_front(key);
             t2_map[key] = {value, t2.begin()};
             return;
@@ -135,52 +435,121 @@ public:
         t1_map[key] = {value, t1.begin()};*/
 
         // Case 5: Super Cache miss
-        if (t1.size() + b1.size() >= capacity)
+        bool scan = scan_policy != ScanPolicy::None && scan_detector.observe(key);
+        if (scan)
         {
-            if (t1.size() < capacity)
-            {
-                if (!b1.empty())
-                {
-                    K lru_key = b1.back();
-                    b1.pop_back();
-                    b1_map.erase(lru_key);
-                }
-                replace(false);
-            }
-            else
+            counters.scan_misses++;
+            if (scan_policy == ScanPolicy::Bypass)
             {
-                K lru_key = t1.back();
-                t1.pop_back();
-                t1_map.erase(lru_key);
+                return;
             }
         }
-        else if (t1.size() + t2.size() + b1.size() + b2.size() >= capacity)
+
+        make_room();
+        // 默认情况下，将新键添加到 T1
+        if (scan)
         {
-            if (t1.size() + t2.size() + b1.size() + b2.size() == 2 * capacity)
-            {
-                if (!b2.empty())
-                {
-                    K lru_key = b2.back();
-                    b2.pop_back();
-                    b2_map.erase(lru_key);
-                }
-            }
-            replace(false);
+            t1.push_back(key); // next in line for replace()
+            t1_map[key] = {value, std::prev(t1.end())};
+            return;
         }
-        // 默认情况下，将新键添加到 T1
         t1.push_front(key);
         t1_map[key] = {value, t1.begin()};
     }
 
+public:
+    // With IndexMode::Presized every map, ghost maps included, is reserved for the most keys
+    // it can hold: capacity each, plus one for B2, which replace() trims after inserting
+    explicit ARCache(size_t size, IndexMode mode = IndexMode::Grow) // Constructor
+        : capacity(size), p(0), index_mode(mode), scan_policy(ScanPolicy::None),
+          t1(CountingAllocator<K>(&index_bytes)), t1_map(CountingAllocator<K>(&entry_bytes)),
+          t2(CountingAllocator<K>(&index_bytes)), t2_map(CountingAllocator<K>(&entry_bytes)),
+          b1(CountingAllocator<K>(&ghost_bytes)), b1_map(CountingAllocator<K>(&ghost_bytes)),
+          b2(CountingAllocator<K>(&ghost_bytes)), b2_map(CountingAllocator<K>(&ghost_bytes)),
+          entry_tags(CountingAllocator<K>(&entry_bytes)), stale(CountingAllocator<K>(&entry_bytes))
+    {
+        if (mode == IndexMode::Presized)
+        {
+            t1_map.reserve(capacity);
+            t2_map.reserve(capacity);
+            b1_map.reserve(capacity);
+            b2_map.reserve(capacity + 1);
+        }
+    }
+
+    void put(const K &key, const V &value) override
+    { // Put key-value pair in cache
+        if (capacity == 0)
+        {
+            return;
+        }
+        if (over_capacity)
+        {
+            shrink(RESIZE_STEP);
+        }
+        if (!retired.empty())
+        {
+            reclaim(RECLAIM_STEP);
+        }
+        expire_if_stale(key);
+        untag(key);
+        store(key, value);
+    }
+
+    // Stores key like put() and attaches it to tag, replacing any tag it had, so that
+    // invalidate_tag(tag) drops it along with every other entry stored under that tag
+    void put_tagged(const K &key, const V &value, Tag tag)
+    {
+        put(key, value);
+        if (contains(key)) // not when the scan policy bypassed it
+        {
+            auto state = tags.find(tag);
+            if (state == tags.end())
+            {
+                state = tags.emplace(tag, TagState{0, KeyList(CountingAllocator<K>(&entry_bytes))}).first;
+            }
+            state->second.keys.push_back(key);
+            entry_tags.emplace(key, TaggedVersion{tag, state->second.version, std::prev(state->second.keys.end())});
+        }
+    }
+
+    // Invalidates every entry currently stored under tag in O(1). The entries stop being
+    // visible at once, but stay resident (and counted by size()) until a lookup finds them
+    // stale and erases them. Replacement drops them, oldest first, before it evicts any live
+    // entry, without ghost entries and without the eviction callback.
+    void invalidate_tag(Tag tag)
+    {
+        auto it = tags.find(tag);
+        if (it != tags.end())
+        {
+            it->second.version++;
+            stale.splice(stale.end(), it->second.keys);
+        }
+    }
+
     bool get(const K &key, V &value) override
     {
+        if (over_capacity)
+        {
+            shrink(RESIZE_STEP);
+        }
+        if (!retired.empty())
+        {
+            reclaim(RECLAIM_STEP);
+        }
+        expire_if_stale(key);
+        if (scan_policy != ScanPolicy::None)
+        {
+            scan_detector.observe(key); // hits keep a scan's run going too
+        }
+
         // Case 1: Key in T1
         if (t1_map.count(key))
         {
             value = t1_map[key].first;
             K k = key;
             V v = value;
-            put(k, v); // This will move it to T2
+            store(k, v); // This will move it to T2
             return true;
         }
 
@@ -190,7 +559,7 @@ public:
             value = t2_map[key].first;
             K k = key;
             V v = value;
-            put(k, v); // This will move it to front of T2
+            store(k, v); // This will move it to front of T2
             return true;
         } // if we find key, return false
 
@@ -202,17 +571,220 @@ public:
         return t1.size() + t2.size();
     }
 
+    // Starts a new, empty generation in O(1): the containers of the current one are swapped
+    // out whole and freed RECLAIM_STEP nodes per later put()/get(), or through reclaim().
+    // Until then their memory stays allocated and in memory_usage(). The new index starts
+    // small even with IndexMode::Presized, since reserving it again would cost as much as
+    // the clear used to.
     void clear() override
     {
-        t1.clear();
-        t2.clear();
-        b1.clear();
-        b2.clear();
-        t1_map.clear();
-        t2_map.clear();
-        b1_map.clear();
-        b2_map.clear();
+        std::unique_ptr<Retired> old(new Retired(&entry_bytes, &index_bytes, &ghost_bytes));
+        old->t1.swap(t1);
+        old->t2.swap(t2);
+        old->b1.swap(b1);
+        old->b2.swap(b2);
+        old->t1_map.swap(t1_map);
+        old->t2_map.swap(t2_map);
+        old->b1_map.swap(b1_map);
+        old->b2_map.swap(b2_map);
+        old->entry_tags.swap(entry_tags);
+        old->tags.swap(tags);
+        old->stale.swap(stale);
+        retired.push_back(std::move(old));
+        current_generation++;
         p = 0;
+        scan_detector.clear();
+        counters = ARCStats();
+    }
+
+    // Enables scan detection: once a run of at least run_threshold keys with a constant
+    // stride is seen, further cold misses on it are handled according to policy
+    void set_scan_policy(ScanPolicy policy, size_t run_threshold = 32)
+    {
+        scan_policy = policy;
+        scan_detector = ScanDetector<K>(run_threshold);
+    }
+
+    // Frees up to budget nodes of the generations retired by clear(), for callers that would
+    // rather reclaim from an idle loop or a timer (under the lock that guards the cache) than
+    // on the request path. Returns true while retired nodes remain.
+    bool reclaim(size_t budget)
+    {
+        while (!retired.empty() && budget > 0)
+        {
+            budget -= retired.back()->free_some(budget);
+            if (retired.back()->empty())
+            {
+                retired.pop_back();
+            }
+        }
+        return !retired.empty();
+    }
+
+    // Growing takes effect at once (a Presized index is reserved for the new capacity here).
+    // Shrinking lowers the bounds at once but evicts the surplus residents, and then the
+    // surplus ghosts, RESIZE_STEP per later put()/get() or through shrink(), so size() can
+    // exceed the capacity for a while; resize(0) clears at once. p keeps its share of the
+    // cache, so the split between recency and frequency learned so far carries over.
+    void resize(size_t new_capacity)
+    {
+        if (new_capacity == 0)
+        {
+            clear();
+        }
+        p = capacity == 0 ? 0 : static_cast<size_t>(static_cast<double>(p) * new_capacity / capacity);
+        if (new_capacity > capacity && index_mode == IndexMode::Presized)
+        {
+            t1_map.reserve(new_capacity);
+            t2_map.reserve(new_capacity);
+            b1_map.reserve(new_capacity);
+            b2_map.reserve(new_capacity + 1);
+        }
+        capacity = new_capacity;
+        over_capacity = shrink_step();
+    }
+
+    // Takes up to budget steps of a pending shrink, for callers that would rather finish it
+    // off the request path. Returns true while the cache is still above its bounds.
+    bool shrink(size_t budget)
+    {
+        while (over_capacity && budget-- > 0)
+        {
+            over_capacity = shrink_step();
+        }
+        return over_capacity;
+    }
+
+    // Number of clear() calls so far
+    uint64_t generation() const
+    {
+        return current_generation;
+    }
+
+    void set_eviction_callback(EvictionCallback callback)
+    {
+        on_evict = std::move(callback);
+    }
+
+    // Evicts one resident entry as replacement would (firing the eviction callback), for
+    // callers that bound the cache by something other than the entry count, such as bytes.
+    // B1 + B2 are then kept no larger than the resident set, the bound ARC's directory has
+    // when the cache is full. Returns false if nothing is resident.
+    bool evict_one()
+    {
+        if (t1.empty() && t2.empty())
+        {
+            return false;
+        }
+        replace(false);
+        while (b1.size() + b2.size() > t1.size() + t2.size())
+        {
+            KeyList &ghosts = b1.size() >= b2.size() ? b1 : b2;
+            (&ghosts == &b1 ? b1_map : b2_map).erase(ghosts.back());
+            ghosts.pop_back();
+        }
+        return true;
+    }
+
+    // Removes key if it is resident, without leaving a ghost entry
+    bool erase(const K &key)
+    {
+        auto it = t1_map.find(key);
+        if (it != t1_map.end())
+        {
+            t1.erase(it->second.second);
+            t1_map.erase(it);
+            untag(key);
+            return true;
+        }
+        it = t2_map.find(key);
+        if (it != t2_map.end())
+        {
+            t2.erase(it->second.second);
+            t2_map.erase(it);
+            untag(key);
+            return true;
+        }
+        return false;
+    }
+
+    // The resident value for key, or nullptr; recency is not updated. The value may be
+    // modified through the pointer until the next call that changes the cache.
+    V *peek(const K &key)
+    {
+        expire_if_stale(key);
+        auto it = t1_map.find(key);
+        if (it != t1_map.end())
+        {
+            return &it->second.first;
+        }
+        it = t2_map.find(key);
+        return it != t2_map.end() ? &it->second.first : nullptr;
+    }
+
+    bool contains(const K &key) const
+    {
+        return (t1_map.count(key) || t2_map.count(key)) && (entry_tags.empty() || !is_stale(key));
+    }
+
+    // Inserts a speculatively loaded key into T1 as if it had been referenced once. It never
+    // enters T2 before a demand access, and a ghost entry for key is dropped, since a
+    // speculative load says nothing about the workload and must not adapt p. Returns false
+    // and changes nothing if key is resident.
+    bool prefetch(const K &key, const V &value)
+    {
+        expire_if_stale(key);
+        if (capacity == 0 || contains(key))
+        {
+            return false;
+        }
+        auto ghost = b1_map.find(key);
+        if (ghost != b1_map.end())
+        {
+            b1.erase(ghost->second);
+            b1_map.erase(ghost);
+        }
+        ghost = b2_map.find(key);
+        if (ghost != b2_map.end())
+        {
+            b2.erase(ghost->second);
+            b2_map.erase(ghost);
+        }
+        make_room();
+        t1.push_front(key);
+        t1_map[key] = {value, t1.begin()};
+        return true;
+    }
+
+    // Looks up key like get(), but counts the access as the first reference to it: a key in
+    // T1 moves to the MRU end of T1 instead of into T2. Meant for the first demand access
+    // to a prefetched key.
+    bool get_first_use(const K &key, V &value)
+    {
+        expire_if_stale(key);
+        auto it = t1_map.find(key);
+        if (it == t1_map.end())
+        {
+            return get(key, value);
+        }
+        value = it->second.first;
+        t1.splice(t1.begin(), t1, it->second.second);
+        return true;
+    }
+
+    ARCStats stats() const
+    {
+        return counters;
+    }
+
+    MemoryUsage memory_usage() const override
+    {
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.ghosts = ghost_bytes.bytes;
+        usage.index = index_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead + ghost_bytes.overhead + index_bytes.overhead;
+        return usage;
     }
 };
 
@@ -0,0 +1,58 @@
+#include "memcache_server.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <pthread.h>
+
+// arcd: a standalone cache daemon speaking the memcached text protocol, backed by
+// byte-bounded ARC shards. Runs until SIGINT or SIGTERM.
+
+int main(int argc, char** argv) {
+    MemcacheServerConfig config;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            config.host = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            config.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--unix") == 0 && i + 1 < argc) {
+            config.unix_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config.threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            config.memory_bytes = std::strtoull(argv[++i], nullptr, 10) << 20;
+        } else if (std::strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            config.shards = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "usage: arcd [--host 127.0.0.1] [--port 11211 | -1] [--unix PATH] [--threads N]"
+                      << " [--memory MB] [--shards N]\n";
+            return 2;
+        }
+    }
+
+    // Block the signals in every thread, then wait for them here
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try {
+        MemcacheServer server(config);
+        server.start();
+        std::cerr << "arcd: " << server.num_loops() << " event loops, " << (config.memory_bytes >> 20) << " MB";
+        if (server.port() >= 0) std::cerr << ", tcp " << config.host << ":" << server.port();
+        if (!config.unix_path.empty()) std::cerr << ", unix " << config.unix_path;
+        std::cerr << "\n";
+
+        int signal = 0;
+        sigwait(&signals, &signal);
+        std::cerr << "arcd: " << strsignal(signal) << ", shutting down (" << server.items().items() << " items)\n";
+        server.stop();
+    } catch (const std::exception& e) {
+        std::cerr << "arcd: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+#ifndef BELADY_CACHE_HPP
+#define BELADY_CACHE_HPP
+
+#include "cache.hpp"
+#include <unordered_map>
+#include <vector>
+#include <queue>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+// A trace prepared for Belady's MIN: its keys plus, for each access, the index of the next
+// access to the same key. It depends only on the trace, so one BeladyTrace serves oracles
+// of every capacity.
+template<typename K>
+struct BeladyTrace {
+    static constexpr uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+
+    std::vector<K> keys;
+    std::vector<uint64_t> next_use; // next_use[i]: next index accessing keys[i], or NEVER
+
+    explicit BeladyTrace(std::vector<K> accesses) : keys(std::move(accesses)), next_use(keys.size(), NEVER) {
+        std::unordered_map<K, uint64_t> last_seen; // reverse pass
+        for (uint64_t i = keys.size(); i-- > 0;) {
+            auto it = last_seen.find(keys[i]);
+            if (it != last_seen.end()) {
+                next_use[i] = it->second;
+                it->second = i;
+            } else {
+                last_seen.emplace(keys[i], i);
+            }
+        }
+    }
+};
+
+// Belady's MIN: the offline optimum, evicting the resident key whose next use is farthest
+// away (and not admitting a key whose next use is later than all of them). It is an
+// oracle, not a cache: it is built from the exact trace it will be replayed against and
+// expects the replay harness protocol of test_cache_scenario, i.e. one get() per access in
+// trace order followed by put() on a miss. Runs in O(n log c) time for n accesses. The
+// trace is shared, not copied: memory_usage() counts only the resident set and the heap.
+template<typename K, typename V>
+class BeladyCache final : public Cache<K, V> {
+private:
+    static constexpr uint64_t NEVER = BeladyTrace<K>::NEVER;
+
+    struct Entry {
+        V value;
+        uint64_t next_use;
+    };
+    using HeapItem = std::pair<uint64_t, K>; // (next use, key), largest next use on top
+    using Heap = std::priority_queue<HeapItem, std::vector<HeapItem, CountingAllocator<HeapItem>>>;
+    template<typename T>
+    using Map = std::unordered_map<K, T, std::hash<K>, std::equal_to<K>, CountingAllocator<std::pair<const K, T>>>;
+
+    size_t capacity;
+    uint64_t cursor; // index of the next access in the trace
+
+    MemoryCounter entry_bytes; // declared before the containers that report to them
+    MemoryCounter index_bytes;
+
+    std::shared_ptr<const BeladyTrace<K>> shared;
+    const std::vector<K>& trace;
+    const std::vector<uint64_t>& next_use;
+    Map<Entry> resident;
+    Heap heap; // may hold stale items whose next use no longer matches resident
+
+    void push(const K& key, uint64_t next) {
+        heap.emplace(next, key);
+        if (heap.size() > 2 * capacity + 16) { // drop the stale items, amortized O(1) per push
+            std::vector<HeapItem, CountingAllocator<HeapItem>> live{CountingAllocator<HeapItem>(&index_bytes)};
+            live.reserve(resident.size());
+            for (const auto& item : resident) live.emplace_back(item.second.next_use, item.first);
+            heap = Heap(std::less<HeapItem>(), std::move(live));
+        }
+    }
+
+    const HeapItem& farthest() { // top of the heap after discarding stale items
+        while (true) {
+            const HeapItem& top = heap.top();
+            auto it = resident.find(top.second);
+            if (it != resident.end() && it->second.next_use == top.first) return top;
+            heap.pop();
+        }
+    }
+
+    // Position of the access a put() refers to: the one just looked up by get()
+    uint64_t current_access(const K& key) {
+        if (cursor > 0 && cursor <= trace.size() && trace[cursor - 1] == key) return cursor - 1;
+        return cursor < trace.size() ? cursor++ : trace.size(); // put() without a get()
+    }
+
+public:
+    BeladyCache(size_t size, std::shared_ptr<const BeladyTrace<K>> accesses)
+        : capacity(size), cursor(0), shared(std::move(accesses)), trace(shared->keys), next_use(shared->next_use),
+          resident(CountingAllocator<K>(&entry_bytes)),
+          heap(std::less<HeapItem>(), std::vector<HeapItem, CountingAllocator<HeapItem>>(CountingAllocator<HeapItem>(&index_bytes))) {}
+
+    BeladyCache(size_t size, std::vector<K> accesses)
+        : BeladyCache(size, std::make_shared<const BeladyTrace<K>>(std::move(accesses))) {}
+
+    void put(const K& key, const V& value) override {
+        if (capacity == 0) return;
+
+        uint64_t pos = current_access(key);
+        uint64_t next = pos < trace.size() ? next_use[pos] : NEVER;
+        auto it = resident.find(key);
+        if (it != resident.end()) {
+            it->second.value = value;
+            return;
+        }
+        if (next == NEVER) return; // never used again: caching it cannot help
+
+        if (resident.size() >= capacity) {
+            const HeapItem& victim = farthest();
+            if (victim.first <= next) return; // every resident key is needed sooner: bypass
+            resident.erase(victim.second);
+            heap.pop();
+        }
+        resident.emplace(key, Entry{value, next});
+        push(key, next);
+    }
+
+    bool get(const K& key, V& value) override {
+        uint64_t pos = cursor < trace.size() && trace[cursor] == key ? cursor++ : trace.size();
+        auto it = resident.find(key);
+        if (it == resident.end()) {
+            return false;
+        }
+        value = it->second.value;
+        if (pos < trace.size()) {
+            it->second.next_use = next_use[pos];
+            push(key, next_use[pos]);
+        }
+        return true;
+    }
+
+    size_t size() const override {
+        return resident.size();
+    }
+
+    void clear() override { // restarts the replay from the beginning of the trace
+        resident.clear();
+        heap = Heap(std::less<HeapItem>(), std::vector<HeapItem, CountingAllocator<HeapItem>>(CountingAllocator<HeapItem>(&index_bytes)));
+        cursor = 0;
+    }
+
+    MemoryUsage memory_usage() const override {
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.index = index_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead + index_bytes.overhead;
+        return usage;
+    }
+};
+
+#endif // BELADY_CACHE_HPP
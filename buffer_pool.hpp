@@ -0,0 +1,279 @@
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include "storage_backend.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/mman.h>
+
+// Counters exposed through BufferPool::stats()
+struct BufferPoolStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t reads = 0;        // pages read from the backend
+    uint64_t writes = 0;       // dirty pages written back
+    uint64_t pinned_skips = 0; // pinned frames passed over while looking for a victim
+};
+
+// Anonymous mapping holding every frame, faulted in up front. With huge pages requested it
+// first tries explicit huge pages (MAP_HUGETLB, needs vm.nr_hugepages), then falls back to a
+// regular mapping advised for transparent huge pages.
+class FrameArena {
+private:
+    static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    char* base;
+    size_t length;
+    bool huge;
+
+public:
+    FrameArena(size_t bytes, bool huge_pages) : base(nullptr), length(bytes), huge(false) {
+        void* mapping = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        if (huge_pages) {
+            size_t rounded = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+            mapping = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+            if (mapping != MAP_FAILED) {
+                length = rounded;
+                huge = true;
+            }
+        }
+#endif
+        if (mapping == MAP_FAILED) {
+            mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+            if (mapping == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap frame arena");
+#ifdef MADV_HUGEPAGE
+            if (huge_pages) madvise(mapping, length, MADV_HUGEPAGE);
+#endif
+        }
+        base = static_cast<char*>(mapping);
+    }
+
+    ~FrameArena() {
+        munmap(base, length);
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    char* data() const { return base; }
+    bool huge_pages() const { return huge; } // explicit huge pages were mapped
+};
+
+// Page cache for a storage engine: fixed-size frames in a FrameArena, replaced by ARC.
+// T1/T2 hold frame numbers and B1/B2 the ids of evicted pages, with the same adaptation of
+// the T1 target p as ARCache. pin() returns the frame holding a page, reading it from the
+// backend on a miss; a pinned frame is never chosen by replace(), and if every frame is
+// pinned pin() throws std::runtime_error. unpin() may mark the page dirty; dirty pages are
+// written back when evicted and by flush()/flush_all(). Backend errors propagate as
+// exceptions and leave the pool consistent. Not thread-safe.
+class BufferPool {
+private:
+    using FrameList = std::list<size_t>;
+    using PageList = std::list<PageId>;
+
+    struct Frame {
+        PageId page = 0;
+        uint32_t pins = 0;
+        bool dirty = false;
+        bool in_t2 = false;
+        FrameList::iterator pos; // position in T1 or T2
+    };
+
+    size_t page_bytes;
+    size_t capacity; // number of frames
+    size_t p;        // Target size for T1
+    StorageBackend& backend;
+    FrameArena arena;
+    BufferPoolStats counters;
+
+    std::vector<Frame> frames;
+    std::vector<size_t> free_frames;
+    std::unordered_map<PageId, size_t> page_table; // resident page -> frame
+
+    FrameList t1; // Recent pages, front is the MRU
+    FrameList t2; // Frequent pages
+    PageList b1;  // Ghosts of pages evicted from T1
+    PageList b2;  // Ghosts of pages evicted from T2
+    std::unordered_map<PageId, PageList::iterator> b1_map;
+    std::unordered_map<PageId, PageList::iterator> b2_map;
+
+    char* frame_data(size_t frame) const {
+        return arena.data() + frame * page_bytes;
+    }
+
+    void write_back(size_t frame) {
+        if (!frames[frame].dirty) return;
+        backend.write_page(frames[frame].page, frame_data(frame), page_bytes);
+        frames[frame].dirty = false;
+        counters.writes++;
+    }
+
+    static void drop_lru(PageList& ghosts, std::unordered_map<PageId, PageList::iterator>& ghost_map) {
+        ghost_map.erase(ghosts.back());
+        ghosts.pop_back();
+    }
+
+    // Evicts the least recently used unpinned frame of T1 (or T2) into B1 (or B2)
+    bool evict_from(bool from_t1, size_t& victim) {
+        FrameList& list = from_t1 ? t1 : t2;
+        for (auto it = list.rbegin(); it != list.rend(); ++it) {
+            size_t frame = *it;
+            if (frames[frame].pins > 0) {
+                counters.pinned_skips++;
+                continue;
+            }
+            write_back(frame); // may throw; nothing has changed yet
+            PageId page = frames[frame].page;
+            list.erase(std::next(it).base());
+            page_table.erase(page);
+            if (from_t1) {
+                b1.push_front(page);
+                b1_map[page] = b1.begin();
+            } else {
+                b2.push_front(page);
+                b2_map[page] = b2.begin();
+                if (b2.size() > capacity) drop_lru(b2, b2_map);
+            }
+            victim = frame;
+            return true;
+        }
+        return false;
+    }
+
+    // ARC's REPLACE: frees a frame from T1 or T2 depending on p, falling back to the other
+    // list when every frame in the preferred one is pinned
+    size_t replace(bool in_b2) {
+        bool from_t1 = !t1.empty() && (t1.size() > p || (in_b2 && t1.size() == p));
+        size_t victim;
+        if (evict_from(from_t1, victim) || evict_from(!from_t1, victim)) return victim;
+        throw std::runtime_error("buffer pool: all frames are pinned");
+    }
+
+    size_t take_frame(bool in_b2) {
+        if (free_frames.empty()) return replace(in_b2);
+        size_t frame = free_frames.back();
+        free_frames.pop_back();
+        return frame;
+    }
+
+public:
+    BufferPool(size_t num_frames, size_t page_size, StorageBackend& backend, bool huge_pages = false)
+        : page_bytes(page_size), capacity(num_frames), p(0), backend(backend),
+          arena(std::max<size_t>(1, num_frames * page_size), huge_pages), frames(num_frames) {
+        if (num_frames == 0 || page_size == 0) throw std::invalid_argument("buffer pool needs frames and a page size");
+        free_frames.reserve(num_frames);
+        for (size_t frame = num_frames; frame-- > 0;) free_frames.push_back(frame);
+        page_table.reserve(num_frames);
+    }
+
+    // Dirty pages are written back on a best-effort basis; call flush_all() first to see errors
+    ~BufferPool() {
+        try {
+            flush_all();
+        } catch (...) {
+        }
+    }
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Returns the page's frame, pinned; it stays valid until the matching unpin()
+    char* pin(PageId page) {
+        auto resident = page_table.find(page);
+        if (resident != page_table.end()) { // Case 1 and 2: move to the MRU end of T2
+            Frame& frame = frames[resident->second];
+            t2.splice(t2.begin(), frame.in_t2 ? t2 : t1, frame.pos);
+            frame.in_t2 = true;
+            frame.pins++;
+            counters.hits++;
+            return frame_data(resident->second);
+        }
+
+        counters.misses++;
+        bool to_t2 = true;
+        size_t frame;
+        auto ghost = b1_map.find(page);
+        if (ghost != b1_map.end()) { // Case 3: B1 hit, favour recency
+            double delta = std::max(1.0, static_cast<double>(b2.size()) / static_cast<double>(std::max<size_t>(1, b1.size())));
+            p = std::min(capacity, static_cast<size_t>(p + delta));
+            b1.erase(ghost->second);
+            b1_map.erase(ghost);
+            frame = take_frame(false);
+        } else if ((ghost = b2_map.find(page)) != b2_map.end()) { // Case 4: B2 hit, favour frequency
+            double delta = std::max(1.0, static_cast<double>(b1.size()) / static_cast<double>(std::max<size_t>(1, b2.size())));
+            p = p >= delta ? static_cast<size_t>(p - delta) : 0;
+            b2.erase(ghost->second);
+            b2_map.erase(ghost);
+            frame = take_frame(true);
+        } else { // Case 5: keep |T1| + |B1| <= c and the whole directory <= 2c
+            to_t2 = false;
+            if (t1.size() + b1.size() >= capacity) {
+                if (!b1.empty()) drop_lru(b1, b1_map);
+            } else if (t1.size() + t2.size() + b1.size() + b2.size() >= 2 * capacity) {
+                if (!b2.empty()) drop_lru(b2, b2_map);
+            }
+            frame = take_frame(false);
+        }
+
+        try {
+            backend.read_page(page, frame_data(frame), page_bytes);
+        } catch (...) {
+            free_frames.push_back(frame);
+            throw;
+        }
+        counters.reads++;
+
+        FrameList& list = to_t2 ? t2 : t1;
+        list.push_front(frame);
+        Frame& slot = frames[frame];
+        slot.page = page;
+        slot.pins = 1;
+        slot.dirty = false;
+        slot.in_t2 = to_t2;
+        slot.pos = list.begin();
+        page_table.emplace(page, frame);
+        return frame_data(frame);
+    }
+
+    void unpin(PageId page, bool dirty = false) {
+        auto resident = page_table.find(page);
+        if (resident == page_table.end() || frames[resident->second].pins == 0) {
+            throw std::logic_error("buffer pool: unpin of a page that is not pinned");
+        }
+        Frame& frame = frames[resident->second];
+        frame.pins--;
+        frame.dirty = frame.dirty || dirty;
+    }
+
+    // Writes the page back if it is resident and dirty
+    void flush(PageId page) {
+        auto resident = page_table.find(page);
+        if (resident != page_table.end()) write_back(resident->second);
+    }
+
+    // Writes back every dirty page, then syncs the backend
+    void flush_all() {
+        for (const auto& resident : page_table) write_back(resident.second);
+        backend.sync();
+    }
+
+    size_t page_size() const { return page_bytes; }
+    size_t num_frames() const { return capacity; }
+    size_t resident() const { return page_table.size(); }
+    bool huge_pages() const { return arena.huge_pages(); }
+
+    BufferPoolStats stats() const {
+        return counters;
+    }
+};
+
+#endif // BUFFER_POOL_HPP
@@ -0,0 +1,111 @@
+#include "buffer_pool.hpp"
+#include "workload.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+// Page reads through a BufferPool over a local file: sequential, uniform random and Zipf
+// page ids, plus a random read/write mix that exercises write-back of dirty victims. The
+// file is created (or overwritten) with each page stamped with its id, and every pinned page
+// is checked against its stamp. Reads that miss the pool may still hit the OS page cache.
+
+template<typename Pattern>
+std::vector<int> materialize(Pattern pattern, size_t length) {
+    auto source = make_stream(std::move(pattern), length);
+    return read_all(source);
+}
+
+int main(int argc, char** argv) {
+    int num_pages = 16384;
+    size_t num_frames = 2048;
+    size_t page_size = 4096;
+    size_t accesses = 200000;
+    bool huge_pages = false;
+    std::string path = "/tmp/buffer_pool_bench.dat";
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--pages") == 0 && i + 1 < argc) {
+            num_pages = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            num_frames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--page-size") == 0 && i + 1 < argc) {
+            page_size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--length") == 0 && i + 1 < argc) {
+            accesses = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else if (std::strcmp(argv[i], "--huge") == 0) {
+            huge_pages = true;
+        }
+    }
+    if (page_size < sizeof(PageId)) {
+        std::cerr << "page size must hold a page id\n";
+        return 1;
+    }
+
+    try {
+        FileBackend backend(path);
+        {
+            std::vector<char> page(page_size, 0);
+            for (int id = 0; id < num_pages; id++) {
+                PageId stamp = id;
+                std::memcpy(page.data(), &stamp, sizeof(stamp));
+                backend.write_page(id, page.data(), page_size);
+            }
+            backend.sync();
+        }
+
+        std::vector<std::pair<std::string, std::vector<int>>> traces;
+        traces.emplace_back("Sequential", materialize(PeriodicPattern(num_pages, num_pages), accesses));
+        traces.emplace_back("Random", materialize(RandomPattern(num_pages), accesses));
+        traces.emplace_back("Zipf(0.99)", materialize(ZipfianPattern(num_pages, 0.99), accesses));
+
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Pages: " << num_pages << ", frames: " << num_frames << ", page size: " << page_size
+                  << ", accesses: " << accesses << "\n";
+        bool warned = false;
+        std::cout << "Pattern\t\tDirtied\tHit Rate (%)\tReads\tWrites\tus/access\tMB/s\n";
+        for (const auto& trace : traces) {
+            for (bool writes : {false, true}) {
+                BufferPool pool(num_frames, page_size, backend, huge_pages);
+                uint64_t corrupt = 0;
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < trace.second.size(); i++) {
+                    PageId id = trace.second[i];
+                    char* frame = pool.pin(id);
+                    PageId stamp;
+                    std::memcpy(&stamp, frame, sizeof(stamp));
+                    if (stamp != id) corrupt++;
+                    bool dirty = writes && i % 4 == 0;
+                    if (dirty) frame[sizeof(PageId)]++; // leaves the stamp intact
+                    pool.unpin(id, dirty);
+                }
+                pool.flush_all();
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                BufferPoolStats stats = pool.stats();
+                std::cout << trace.first << "\t" << (writes ? "25%" : "0%") << "\t"
+                          << 100.0 * stats.hits / trace.second.size() << "%\t\t"
+                          << stats.reads << "\t" << stats.writes << "\t"
+                          << seconds * 1e6 / trace.second.size() << "\t\t"
+                          << trace.second.size() * page_size / seconds / 1e6 << "\n";
+                if (corrupt) std::cerr << corrupt << " pages did not hold their own id\n";
+                if (huge_pages && !pool.huge_pages() && !warned) {
+                    std::cerr << "explicit huge pages unavailable, using THP advice\n";
+                    warned = true;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        ::unlink(path.c_str());
+        return 1;
+    }
+    ::unlink(path.c_str());
+    return 0;
+}
@@ -1,18 +1,52 @@
 #ifndef CACHE_HPP
 #define CACHE_HPP
 
+#include "memory_usage.hpp"
 #include <unordered_map>
 #include <list>
 #include <cstddef>
 
+// How a policy sizes its hash index. Grow lets std::unordered_map rehash as it fills, and a
+// rehash moves every node inside a single put(). Presized reserves buckets for the most
+// entries the capacity allows when the cache is built, so put() never rehashes; the full
+// bucket arrays are paid for from the start.
+enum class IndexMode {
+    Grow,
+    Presized
+};
+
+// Entries a cache evicts per put()/get(), beyond what the operation itself needs, while it
+// is above a capacity lowered by resize()
+const size_t RESIZE_STEP = 4;
+
 template<typename K, typename V>
 class Cache { //abstract class, it cannot be instantiated
 public:
+    Cache() = default;
+    Cache(const Cache&) = delete; // containers hold allocators that point into the cache
+    Cache& operator=(const Cache&) = delete;
     virtual ~Cache() = default;
     virtual void put(const K& key, const V& value) = 0;
     virtual bool get(const K& key, V& value) = 0;
     virtual size_t size() const = 0;
     virtual void clear() = 0;
+    virtual MemoryUsage memory_usage() const = 0;
+};
+
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+#include <concepts>
+
+// Static counterpart of Cache: generic code constrained on CachePolicy calls the policy
+// directly, so get/put can be inlined. The policies are final, which lets the compiler
+// devirtualize any call made through the concrete type; Cache stays the type-erased interface.
+template<typename C, typename K, typename V>
+concept CachePolicy = requires(C& cache, const C& const_cache, const K& key, const V& value, V& out) {
+    cache.put(key, value);
+    { cache.get(key, out) } -> std::convertible_to<bool>;
+    { const_cache.size() } -> std::convertible_to<size_t>;
+    cache.clear();
+    { const_cache.memory_usage() } -> std::same_as<MemoryUsage>;
 };
+#endif
 
 #endif // CACHE_HPP
@@ -0,0 +1,240 @@
+#ifndef CACHE_ARBITER_HPP
+#define CACHE_ARBITER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Reuse distances of a spatially hashed sample of one cache's accesses (SHARDS, Waldspurger
+// et al., 2015): a key is sampled if its hash falls below rate, so every access to it is,
+// and the distances between sampled keys scale by 1 / rate to distances in the full stream.
+// The resulting LRU miss-ratio curve is close enough to ARC's to rank caches by. Each sampled
+// access gets the next timestamp, and a Fenwick tree over the timestamps marks the last
+// access of every tracked key, so a reuse distance (the keys accessed since) is a difference
+// of two prefix sums: O(log max_depth) per sampled access. When the timestamps run out, the
+// newest max_depth keys are renumbered from 0 and older ones forgotten.
+class ReuseSampler {
+private:
+    static const uint64_t MODULUS = uint64_t(1) << 24;
+
+    double rate;
+    uint64_t threshold;
+    size_t max_depth; // sampled keys tracked; longer reuses count as cold misses
+    std::unordered_map<uint64_t, size_t> last_access; // sampled key -> timestamp of its last access
+    std::vector<uint32_t> marks; // Fenwick tree: 1 at the last access of each tracked key
+    size_t now;                  // next timestamp
+    std::vector<double> reuses;  // [d]: reuses at sampled distance d, scaled to the full stream
+
+    static uint64_t spread(uint64_t hash) {
+        return hash * 0x9e3779b97f4a7c15ULL; // spread identity hashes of integers
+    }
+
+    void mark(size_t t, int32_t delta) {
+        for (size_t i = t + 1; i <= marks.size(); i += i & (~i + 1)) marks[i - 1] += delta;
+    }
+
+    size_t marked_before(size_t t) const {
+        size_t count = 0;
+        for (size_t i = t; i > 0; i -= i & (~i + 1)) count += marks[i - 1];
+        return count;
+    }
+
+    // Renumbers the newest max_depth keys from 0 into a tree with room for as many more
+    void renumber() {
+        std::vector<std::pair<size_t, uint64_t>> order; // (timestamp, key)
+        order.reserve(last_access.size());
+        for (const auto& entry : last_access) order.emplace_back(entry.second, entry.first);
+        std::sort(order.begin(), order.end());
+        size_t keep = std::min(order.size(), max_depth);
+        last_access.clear();
+        marks.assign(2 * max_depth + 16, 0);
+        for (size_t t = 0; t < keep; t++) {
+            last_access.emplace(order[order.size() - keep + t].second, t);
+            mark(t, 1);
+        }
+        now = keep;
+    }
+
+public:
+    explicit ReuseSampler(double rate, size_t max_distance = 0)
+        : rate(rate), threshold(static_cast<uint64_t>(rate * MODULUS)), max_depth(0), now(0) {
+        set_max_distance(max_distance);
+    }
+
+    // Longest reuse distance, in entries of the full stream, that the curve has to cover
+    void set_max_distance(size_t max_distance) {
+        max_depth = static_cast<size_t>(std::ceil(max_distance * rate)) + 1;
+        reuses.resize(max_depth, 0.0);
+        renumber();
+    }
+
+    // Whether accesses to the key with this hash are sampled at all
+    bool samples(uint64_t hash) const {
+        return (spread(hash) >> 40) < threshold;
+    }
+
+    void access(uint64_t hash) {
+        if (!samples(hash)) return;
+        hash = spread(hash);
+        if (now == marks.size()) renumber();
+        auto it = last_access.find(hash);
+        if (it == last_access.end()) {
+            last_access.emplace(hash, now);
+        } else {
+            size_t depth = marked_before(now) - marked_before(it->second + 1);
+            if (depth < max_depth) reuses[depth] += 1.0 / rate;
+            mark(it->second, -1);
+            it->second = now;
+        }
+        mark(now++, 1);
+    }
+
+    // Estimated accesses that an LRU cache of hi entries would hit and one of lo would miss
+    double hits_between(double lo, double hi) const {
+        double total = 0;
+        lo *= rate;
+        hi *= rate;
+        // a reuse at sampled depth d hits any cache of more than d / rate entries
+        for (size_t d = static_cast<size_t>(std::max(0.0, std::floor(lo))); d < reuses.size() && d < hi; d++) {
+            double covered = std::min(hi, d + 1.0) - std::max(lo, static_cast<double>(d));
+            if (covered > 0) total += reuses[d] * covered;
+        }
+        return total;
+    }
+
+    // Scales the curve down, so older accesses weigh less than recent ones
+    void decay(double factor) {
+        for (double& count : reuses) count *= factor;
+    }
+};
+
+struct CacheArbiterConfig {
+    double step = 0.05;          // entries moved per transfer, as a share of the mean capacity
+    double min_gain = 1.5;       // transfer only if the receiver gains this many times what the donor loses
+    size_t min_capacity = 16;    // no cache is shrunk below this
+    double sample_rate = 0.01;   // share of the key space sampled for the curves
+    double decay = 0.5;          // weight left to the curve of earlier intervals at each rebalance
+};
+
+// Splits a fixed total capacity among several caches to maximize their combined hits. Each
+// cache's accesses are fed to record(), which samples its miss-ratio curve; rebalance() then
+// repeatedly moves step entries from the cache that loses fewest hits by shrinking (the
+// curve just below its capacity) to the one that gains most by growing (just above it),
+// while the gain is at least min_gain times the loss, at most once per cache. The total
+// never changes; donors shrink incrementally and receivers grow at once (see resize()).
+//
+// Ghost hits (ARC's B1/B2) were the other candidate estimate, but they only see the gain of
+// growing: a cache whose working set fits exactly has no ghost hits and would be shrunk off
+// its cliff. Like any marginal scheme this one cannot see a cliff further away than one step.
+// Capacities are entry counts; nothing runs until the owner calls rebalance(). record() may
+// be called from any thread: only the sampled accesses (sample_rate of them) take the
+// tenant's lock. Register every cache before recording starts.
+class CacheArbiter {
+private:
+    struct Tenant {
+        std::function<void(size_t)> resize; // over a shared cache it takes the cache's lock
+        size_t capacity;
+        ReuseSampler sampler;
+        bool moved; // in this rebalance
+        std::unique_ptr<std::mutex> mutex; // guards sampler
+    };
+
+    CacheArbiterConfig config;
+    std::vector<Tenant> tenants;
+    size_t total = 0;
+
+public:
+    explicit CacheArbiter(CacheArbiterConfig config = CacheArbiterConfig()) : config(config) {
+        if (config.step <= 0 || config.step >= 1) throw std::invalid_argument("cache arbiter: step must be in (0, 1)");
+        if (config.sample_rate <= 0 || config.sample_rate > 1) {
+            throw std::invalid_argument("cache arbiter: sample rate must be in (0, 1]");
+        }
+    }
+
+    // Registers a cache through its resize function, with its current capacity; returns its index
+    size_t add(std::function<void(size_t)> resize, size_t capacity) {
+        total += capacity;
+        tenants.push_back({std::move(resize), capacity, ReuseSampler(config.sample_rate), false,
+                           std::unique_ptr<std::mutex>(new std::mutex)});
+        for (Tenant& tenant : tenants) { // no cache can grow past the total
+            std::lock_guard<std::mutex> lock(*tenant.mutex);
+            tenant.sampler.set_max_distance(total);
+        }
+        return tenants.size() - 1;
+    }
+
+    // Registers a cache with a resize() member (ARCache, LRUCache, LFUCache) used only by the
+    // thread that calls rebalance()
+    template<typename C>
+    auto add(C& cache, size_t capacity) -> decltype(cache.resize(capacity), size_t()) {
+        return add([&cache](size_t target) { cache.resize(target); }, capacity);
+    }
+
+    // Feeds one access of cache i to its curve; call it for every get()
+    template<typename K>
+    void record(size_t i, const K& key) {
+        Tenant& tenant = tenants[i];
+        uint64_t hash = std::hash<K>()(key);
+        if (!tenant.sampler.samples(hash)) return;
+        std::lock_guard<std::mutex> lock(*tenant.mutex);
+        tenant.sampler.access(hash);
+    }
+
+    // Moves capacity as the curves since the last call suggest; returns the entries moved
+    size_t rebalance() {
+        if (tenants.size() < 2) return 0;
+        size_t amount = std::max<size_t>(1, static_cast<size_t>(config.step * total / tenants.size()));
+        double width = static_cast<double>(amount);
+        for (Tenant& tenant : tenants) tenant.moved = false;
+        size_t moved = 0;
+        while (true) {
+            Tenant* receiver = nullptr;
+            Tenant* donor = nullptr;
+            double best_gain = 0, least_loss = 0;
+            for (Tenant& tenant : tenants) {
+                if (tenant.moved) continue;
+                double c = static_cast<double>(tenant.capacity);
+                std::lock_guard<std::mutex> lock(*tenant.mutex);
+                double gain = tenant.sampler.hits_between(c, c + width);
+                if (!receiver || gain > best_gain) {
+                    receiver = &tenant;
+                    best_gain = gain;
+                }
+            }
+            for (Tenant& tenant : tenants) {
+                if (tenant.moved || &tenant == receiver || tenant.capacity < config.min_capacity + amount) continue;
+                double c = static_cast<double>(tenant.capacity);
+                std::lock_guard<std::mutex> lock(*tenant.mutex);
+                double loss = tenant.sampler.hits_between(c - width, c);
+                if (!donor || loss < least_loss) {
+                    donor = &tenant;
+                    least_loss = loss;
+                }
+            }
+            if (!receiver || !donor || best_gain <= 0 || best_gain < config.min_gain * least_loss) break;
+            donor->capacity -= amount;
+            receiver->capacity += amount;
+            donor->resize(donor->capacity);
+            receiver->resize(receiver->capacity);
+            donor->moved = receiver->moved = true;
+            moved += amount;
+        }
+        for (Tenant& tenant : tenants) {
+            std::lock_guard<std::mutex> lock(*tenant.mutex);
+            tenant.sampler.decay(config.decay);
+        }
+        return moved;
+    }
+
+    size_t capacity(size_t i) const { return tenants.at(i).capacity; }
+    size_t size() const { return tenants.size(); }
+};
+
+#endif // CACHE_ARBITER_HPP
@@ -0,0 +1,330 @@
+#include "arc_cache.hpp"
+#include "lru_cache.hpp"
+#include "lfu_cache.hpp"
+#include "s3fifo_cache.hpp"
+#include "sieve_cache.hpp"
+#include "lirs_cache.hpp"
+#include "two_q_cache.hpp"
+#include "slru_cache.hpp"
+#include "concurrent_cache.hpp"
+#include "latency_histogram.hpp"
+#include "memcache_client.hpp"
+#include "workload.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// cacheload: drives cache-aside traffic (get, then set on a miss) at an in-process cache or
+// a memcached-protocol server, from a generated key distribution or a trace file.
+//
+// Closed loop: each of --concurrency workers sends its next request as soon as the previous
+// one completes; latency is measured from the send. Open loop: request i is due at a fixed
+// time (i / --rate, or its recorded timestamp when replaying a timed trace) whether or not
+// earlier requests have completed, and latency is measured from that intended time, so a
+// stalled target shows up in the tail instead of silently lowering the offered load.
+
+using Clock = std::chrono::steady_clock;
+
+// One worker's handle on the target
+class Session {
+public:
+    virtual ~Session() = default;
+    // One cache-aside access; returns true on a hit
+    virtual bool access(int key) = 0;
+};
+
+class EmbeddedSession : public Session {
+private:
+    Cache<int, int>& cache;
+
+public:
+    explicit EmbeddedSession(Cache<int, int>& cache) : cache(cache) {}
+
+    bool access(int key) override {
+        int value;
+        if (cache.get(key, value)) return true;
+        cache.put(key, key);
+        return false;
+    }
+};
+
+std::string value_for(int key, size_t size) {
+    std::string value(size, '\0');
+    for (size_t i = 0; i < size; i++) value[i] = static_cast<char>('a' + (key + i) % 26);
+    return value;
+}
+
+class ServerSession : public Session {
+private:
+    std::unique_ptr<MemcacheClient> client;
+    size_t value_size;
+    std::atomic<uint64_t>& corrupt;
+
+public:
+    ServerSession(std::unique_ptr<MemcacheClient> client, size_t value_size, std::atomic<uint64_t>& corrupt)
+        : client(std::move(client)), value_size(value_size), corrupt(corrupt) {}
+
+    bool access(int key) override {
+        std::string name = std::to_string(key);
+        std::string value;
+        if (client->get(name, value)) {
+            if (value != value_for(key, value_size)) corrupt++;
+            return true;
+        }
+        client->set(name, value_for(key, value_size));
+        return false;
+    }
+};
+
+void usage() {
+    std::cerr << "usage: cacheload [target] [load] [keys]\n"
+              << "  target: --cache arc|lru|lfu|s3fifo|sieve|lirs|2q|slru [--capacity N] (in process, default arc)\n"
+              << "          --server HOST:PORT | --unix PATH [--value-size BYTES]\n"
+              << "  load:   --mode closed|open  --concurrency N  --rate OPS (open loop)  --speed X (timed traces)\n"
+              << "  keys:   --pattern random|locality|periodic|zipf [--keys N] [--length N] [--skew S]\n"
+              << "          [--locality N] [--period N] | --trace FILE (lines: \"key\" or \"seconds key\")\n"
+              << "  output: --hgrm FILE (full percentile distribution, HdrHistogram text format)\n";
+}
+
+int main(int argc, char** argv) {
+    std::string cache_name = "arc";
+    size_t capacity = 100000;
+    std::string server;
+    std::string unix_path;
+    size_t value_size = 100;
+    bool open_loop = false;
+    size_t concurrency = 4;
+    double rate = 0.0;  // requests per second over all workers
+    double speed = 1.0; // timed trace replay speed-up
+    std::string pattern = "zipf";
+    int data_range = 1000000;
+    size_t pattern_length = 1000000;
+    double skew = 0.99;
+    int locality = 100;
+    int period = 1000;
+    std::string trace_path;
+    std::string hgrm_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--cache" && has_value) {
+            cache_name = argv[++i];
+        } else if (arg == "--capacity" && has_value) {
+            capacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--server" && has_value) {
+            server = argv[++i];
+        } else if (arg == "--unix" && has_value) {
+            unix_path = argv[++i];
+        } else if (arg == "--value-size" && has_value) {
+            value_size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--mode" && has_value) {
+            std::string mode = argv[++i];
+            if (mode != "open" && mode != "closed") {
+                usage();
+                return 2;
+            }
+            open_loop = mode == "open";
+        } else if (arg == "--concurrency" && has_value) {
+            concurrency = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--rate" && has_value) {
+            rate = std::atof(argv[++i]);
+        } else if (arg == "--speed" && has_value) {
+            speed = std::atof(argv[++i]);
+        } else if (arg == "--pattern" && has_value) {
+            pattern = argv[++i];
+        } else if (arg == "--keys" && has_value) {
+            data_range = std::atoi(argv[++i]);
+        } else if (arg == "--length" && has_value) {
+            pattern_length = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--skew" && has_value) {
+            skew = std::atof(argv[++i]);
+        } else if (arg == "--locality" && has_value) {
+            locality = std::atoi(argv[++i]);
+        } else if (arg == "--period" && has_value) {
+            period = std::atoi(argv[++i]);
+        } else if (arg == "--trace" && has_value) {
+            trace_path = argv[++i];
+        } else if (arg == "--hgrm" && has_value) {
+            hgrm_path = argv[++i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    // Keys, and the second at which each is due when replaying a timed trace. Generated
+    // up front so that only requests are timed.
+    TimedTrace workload;
+    try {
+        if (!trace_path.empty()) {
+            workload = read_timed_trace(trace_path);
+        } else if (pattern == "random") {
+            auto source = make_stream(RandomPattern(data_range), pattern_length);
+            workload.keys = read_all(source);
+        } else if (pattern == "locality") {
+            auto source = make_stream(LocalityPattern(data_range, locality), pattern_length);
+            workload.keys = read_all(source);
+        } else if (pattern == "periodic") {
+            auto source = make_stream(PeriodicPattern(data_range, period), pattern_length);
+            workload.keys = read_all(source);
+        } else if (pattern == "zipf") {
+            auto source = make_stream(ZipfianPattern(data_range, skew), pattern_length);
+            workload.keys = read_all(source);
+        } else {
+            usage();
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    if (workload.keys.empty()) {
+        std::cerr << "no accesses to replay\n";
+        return 1;
+    }
+    // A fixed rate overrides the trace's own timing
+    bool timed = open_loop && rate <= 0.0 && !workload.times.empty();
+    if (open_loop && rate <= 0.0 && !timed) {
+        std::cerr << "open loop needs --rate, or a trace with timestamps\n";
+        return 2;
+    }
+    if (timed && speed <= 0.0) {
+        std::cerr << "--speed must be positive\n";
+        return 2;
+    }
+
+    // The target: one shared in-process cache, or one connection per worker
+    std::map<std::string, std::function<std::unique_ptr<Cache<int, int>>(size_t)>> factories = {
+        {"arc", [](size_t size) { return std::make_unique<ARCache<int, int>>(size); }},
+        {"lru", [](size_t size) { return std::make_unique<LRUCache<int, int>>(size); }},
+        {"lfu", [](size_t size) { return std::make_unique<LFUCache<int, int>>(size); }},
+        {"s3fifo", [](size_t size) { return std::make_unique<S3FIFOCache<int, int>>(size); }},
+        {"sieve", [](size_t size) { return std::make_unique<SieveCache<int, int>>(size); }},
+        {"lirs", [](size_t size) { return std::make_unique<LIRSCache<int, int>>(size); }},
+        {"2q", [](size_t size) { return std::make_unique<TwoQCache<int, int>>(size); }},
+        {"slru", [](size_t size) { return std::make_unique<SLRUCache<int, int>>(size); }}
+    };
+    const size_t SHARDS = 16;
+    std::unique_ptr<Cache<int, int>> cache;
+    std::atomic<uint64_t> corrupt(0);
+    std::string target;
+    std::vector<std::unique_ptr<Session>> sessions;
+    try {
+        if (!server.empty() || !unix_path.empty()) {
+            std::string host;
+            int port = 0;
+            if (!server.empty()) {
+                size_t colon = server.rfind(':');
+                if (colon == std::string::npos) {
+                    usage();
+                    return 2;
+                }
+                host = server.substr(0, colon);
+                port = std::atoi(server.c_str() + colon + 1);
+            }
+            target = server.empty() ? "unix:" + unix_path : "tcp:" + server;
+            for (size_t w = 0; w < concurrency; w++) {
+                auto client = server.empty() ? MemcacheClient::connect_unix(unix_path)
+                                             : MemcacheClient::connect_tcp(host, port);
+                sessions.push_back(std::make_unique<ServerSession>(std::move(client), value_size, corrupt));
+            }
+        } else {
+            auto factory = factories.find(cache_name);
+            if (factory == factories.end()) {
+                usage();
+                return 2;
+            }
+            target = cache_name + " (" + std::to_string(SHARDS) + " shards, capacity " + std::to_string(capacity) + ")";
+            cache = std::make_unique<ShardedCache<int, int>>(capacity, SHARDS, factory->second);
+            for (size_t w = 0; w < concurrency; w++) sessions.push_back(std::make_unique<EmbeddedSession>(*cache));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    // Worker w issues requests w, w + concurrency, ... so the workers share one timeline
+    std::vector<LatencyHistogram> histograms(concurrency);
+    std::vector<uint64_t> hits(concurrency, 0);
+    std::vector<std::string> errors(concurrency);
+    std::atomic<size_t> ready(0);
+    std::atomic<bool> go(false);
+    Clock::time_point start;
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < concurrency; w++) {
+        threads.emplace_back([&, w] {
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            try {
+                for (size_t i = w; i < workload.keys.size(); i += concurrency) {
+                    Clock::time_point sent;
+                    if (open_loop) {
+                        double due = timed ? workload.times[i] / speed : i / rate;
+                        sent = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(due));
+                        std::this_thread::sleep_until(sent); // returns at once when running behind
+                    } else {
+                        sent = Clock::now();
+                    }
+                    if (sessions[w]->access(workload.keys[i])) hits[w]++;
+                    histograms[w].record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sent).count());
+                }
+            } catch (const std::exception& e) {
+                errors[w] = e.what();
+            }
+        });
+    }
+    while (ready.load() < concurrency) std::this_thread::yield();
+    start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+    LatencyHistogram latency;
+    uint64_t total_hits = 0;
+    for (size_t w = 0; w < concurrency; w++) {
+        latency.merge(histograms[w]);
+        total_hits += hits[w];
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Target: " << target << "\n";
+    std::cout << "Load: " << (open_loop ? "open loop, " : "closed loop, ") << concurrency << " workers";
+    if (open_loop && timed) std::cout << ", trace timestamps x" << speed;
+    if (open_loop && !timed) std::cout << ", " << rate << " req/s offered";
+    std::cout << "\nKeys: "
+              << (trace_path.empty() ? pattern + " over " + std::to_string(data_range) : "trace " + trace_path)
+              << ", " << workload.keys.size() << " requests\n";
+    std::cout << "Throughput: " << latency.count() / seconds << " req/s over " << seconds << " s, hit rate "
+              << 100.0 * total_hits / latency.count() << "%\n";
+    std::cout << "Latency (us)\tmean\tp50\tp90\tp99\tp99.9\tp99.99\tmax\n\t\t" << latency.mean() / 1e3;
+    for (double percentile : {50.0, 90.0, 99.0, 99.9, 99.99}) std::cout << "\t" << latency.value_at(percentile) / 1e3;
+    std::cout << "\t" << latency.max() / 1e3 << "\n";
+    if (corrupt) std::cerr << corrupt << " hits returned a wrong value\n";
+
+    if (!hgrm_path.empty()) {
+        std::ofstream out(hgrm_path);
+        if (!out) {
+            std::cerr << "cannot write " << hgrm_path << "\n";
+            return 1;
+        }
+        latency.write_hgrm(out, 1e3);
+    }
+    return corrupt ? 1 : 0;
+}
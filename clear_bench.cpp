@@ -0,0 +1,81 @@
+#include "arc_cache.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+// Cost of ARCache::clear() on a full cache. clear() retires the current generation in O(1)
+// and frees it RECLAIM_STEP nodes per later put()/get(); reclaiming everything at once is
+// what an eager clear costs. The second run counts the puts it takes, after clear(), until
+// the retired generation is gone, and times the slowest of them against the same puts into
+// a new cache: both pay for the rehashes of a growing index, so the difference is what
+// reclaiming adds.
+
+using Clock = std::chrono::steady_clock;
+
+static void fill(ARCache<int, int>& cache, size_t entries) {
+    for (size_t i = 0; i < entries; i++) {
+        cache.put(static_cast<int>(i), static_cast<int>(i));
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t entries = 1000000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--entries") == 0 && i + 1 < argc) {
+            entries = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "ARC with " << entries << " resident entries\n";
+
+    double clear_us, reclaim_ms;
+    size_t retired_mb;
+    {
+        ARCache<int, int> cache(entries);
+        fill(cache, entries);
+        auto start = Clock::now();
+        cache.clear();
+        clear_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        retired_mb = cache.memory_usage().total() >> 20;
+        start = Clock::now();
+        cache.reclaim(SIZE_MAX);
+        reclaim_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    uint64_t puts = 0;
+    double slowest_us = 0;
+    {
+        ARCache<int, int> cache(entries);
+        fill(cache, entries);
+        cache.clear();
+        while (cache.reclaim(0)) {
+            int key = static_cast<int>(entries + puts++);
+            auto start = Clock::now();
+            cache.put(key, key);
+            double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            if (us > slowest_us) slowest_us = us;
+        }
+    }
+
+    double baseline_us = 0;
+    {
+        ARCache<int, int> cache(entries);
+        for (uint64_t i = 0; i < puts; i++) {
+            int key = static_cast<int>(entries + i);
+            auto start = Clock::now();
+            cache.put(key, key);
+            double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            if (us > baseline_us) baseline_us = us;
+        }
+    }
+
+    std::cout << "clear()\t\t\t" << clear_us << " us (" << retired_mb << " MB retired)\n";
+    std::cout << "reclaim(all)\t\t" << reclaim_ms << " ms (the cost of an eager clear)\n";
+    std::cout << "Puts until reclaimed\t" << puts << ", slowest " << slowest_us << " us (" << baseline_us
+              << " us into a new cache)\n";
+    return 0;
+}
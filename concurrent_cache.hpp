@@ -0,0 +1,247 @@
+#ifndef CONCURRENT_CACHE_HPP
+#define CONCURRENT_CACHE_HPP
+
+#include "cache.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Makes any Cache thread-safe behind a single mutex
+template<typename K, typename V>
+class LockedCache final : public Cache<K, V> {
+private:
+    mutable std::mutex mutex;
+    std::unique_ptr<Cache<K, V>> cache;
+
+public:
+    explicit LockedCache(std::unique_ptr<Cache<K, V>> cache) : cache(std::move(cache)) {}
+
+    void put(const K& key, const V& value) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        cache->put(key, value);
+    }
+
+    bool get(const K& key, V& value) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cache->get(key, value);
+    }
+
+    size_t size() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cache->size();
+    }
+
+    void clear() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        cache->clear();
+    }
+
+    MemoryUsage memory_usage() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cache->memory_usage();
+    }
+};
+
+// Splits the key space over independently locked shards, each with its share of the capacity.
+// Every shard runs the policy on its own keys only, so hit ratios drift slightly from the unsharded policy.
+template<typename K, typename V>
+class ShardedCache final : public Cache<K, V> {
+private:
+    std::vector<std::unique_ptr<LockedCache<K, V>>> shards;
+
+    LockedCache<K, V>& shard_for(const K& key) const {
+        // mix the hash so that identity hashes of integers still spread over the shards
+        size_t h = std::hash<K>()(key) * 0x9e3779b97f4a7c15ULL;
+        return *shards[(h >> 32) % shards.size()];
+    }
+
+public:
+    using Factory = std::function<std::unique_ptr<Cache<K, V>>(size_t)>;
+
+    ShardedCache(size_t size, size_t num_shards, const Factory& factory) {
+        for (size_t i = 0; i < num_shards; i++) {
+            size_t shard_size = size / num_shards + (i < size % num_shards ? 1 : 0);
+            shards.push_back(std::make_unique<LockedCache<K, V>>(factory(shard_size)));
+        }
+    }
+
+    void put(const K& key, const V& value) override {
+        shard_for(key).put(key, value);
+    }
+
+    bool get(const K& key, V& value) override {
+        return shard_for(key).get(key, value);
+    }
+
+    size_t size() const override {
+        size_t total = 0;
+        for (const auto& shard : shards) total += shard->size();
+        return total;
+    }
+
+    void clear() override {
+        for (auto& shard : shards) shard->clear();
+    }
+
+    MemoryUsage memory_usage() const override {
+        MemoryUsage usage;
+        for (const auto& shard : shards) usage += shard->memory_usage();
+        return usage;
+    }
+};
+
+// Makes any Cache thread-safe by flat combining: a thread publishes its get or put in a slot
+// of a shared array, and whichever thread holds the combiner lock applies every published
+// request to the cache in one pass while the others wait on their own slot. The cache's
+// lists and maps then stay in the combiner's core's cache for a whole batch instead of
+// moving between cores with every operation, which suits policies with a lot of shared
+// state per operation such as ARC. Slots are claimed per operation, starting at one picked
+// by thread id; when every slot is busy a thread takes the lock and applies its own request.
+// An exception thrown by the cache for a published request is handed back to the thread
+// that made it, and the combiner lock is released on every path.
+template<typename K, typename V>
+class CombiningCache final : public Cache<K, V> {
+private:
+    enum SlotState : uint32_t { Free, Claimed, Pending, Done };
+    enum class Op : uint32_t { Get, Put };
+
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> state{Free};
+        Op op = Op::Get;
+        const K* key = nullptr;
+        const V* in = nullptr; // put
+        V* out = nullptr;      // get
+        bool result = false;
+        std::exception_ptr error; // thrown by the cache while applying the request
+    };
+
+    static const unsigned SPINS = 64; // checks of a pending slot between yields
+
+    // The combiner lock: test and test-and-set, so waiters read a shared line instead of
+    // writing it. Lockable, so std::lock_guard and std::unique_lock release it on a throw.
+    class SpinLock {
+    private:
+        std::atomic<bool> held{false};
+
+    public:
+        bool try_lock() {
+            return !held.load(std::memory_order_relaxed) && !held.exchange(true, std::memory_order_acquire);
+        }
+
+        void lock() {
+            for (unsigned round = 1; !try_lock(); round++) {
+                if (round % SPINS == 0) std::this_thread::yield();
+            }
+        }
+
+        void unlock() {
+            held.store(false, std::memory_order_release);
+        }
+    };
+
+    std::unique_ptr<Cache<K, V>> cache;
+    alignas(64) mutable SpinLock combiner;
+    std::vector<Slot> slots;
+
+    bool apply(Op op, const K& key, const V* in, V* out) {
+        if (op == Op::Put) {
+            cache->put(key, *in);
+            return true;
+        }
+        return cache->get(key, *out);
+    }
+
+    // Serves every pending request, passing over the slots until one pass finds none
+    void combine() {
+        bool found = true;
+        for (int pass = 0; found && pass < 4; pass++) {
+            found = false;
+            for (Slot& slot : slots) {
+                if (slot.state.load(std::memory_order_acquire) != Pending) continue;
+                try {
+                    slot.result = apply(slot.op, *slot.key, slot.in, slot.out);
+                } catch (...) {
+                    slot.error = std::current_exception();
+                }
+                slot.state.store(Done, std::memory_order_release);
+                found = true;
+            }
+        }
+    }
+
+    Slot* claim() {
+        size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % slots.size();
+        for (size_t i = 0; i < slots.size(); i++) {
+            Slot& slot = slots[(start + i) % slots.size()];
+            uint32_t expected = Free;
+            if (slot.state.load(std::memory_order_relaxed) == Free &&
+                slot.state.compare_exchange_strong(expected, Claimed, std::memory_order_acquire)) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    bool execute(Op op, const K& key, const V* in, V* out) {
+        Slot* slot = claim();
+        if (!slot) {
+            std::lock_guard<SpinLock> lock(combiner);
+            return apply(op, key, in, out);
+        }
+        slot->op = op;
+        slot->key = &key;
+        slot->in = in;
+        slot->out = out;
+        slot->state.store(Pending, std::memory_order_release);
+        for (unsigned round = 0; slot->state.load(std::memory_order_acquire) != Done; round++) {
+            std::unique_lock<SpinLock> lock(combiner, std::try_to_lock);
+            if (lock.owns_lock()) {
+                combine(); // includes this thread's request
+            } else if (round % SPINS == SPINS - 1) {
+                std::this_thread::yield();
+            }
+        }
+        bool result = slot->result;
+        std::exception_ptr error = std::move(slot->error);
+        slot->error = nullptr;
+        slot->state.store(Free, std::memory_order_release);
+        if (error) std::rethrow_exception(error);
+        return result;
+    }
+
+public:
+    // slot_count defaults to twice the hardware threads, so claims rarely collide
+    explicit CombiningCache(std::unique_ptr<Cache<K, V>> cache, size_t slot_count = 0)
+        : cache(std::move(cache)),
+          slots(slot_count ? slot_count : std::max<size_t>(16, 2 * std::thread::hardware_concurrency())) {}
+
+    void put(const K& key, const V& value) override {
+        execute(Op::Put, key, &value, nullptr);
+    }
+
+    bool get(const K& key, V& value) override {
+        return execute(Op::Get, key, nullptr, &value);
+    }
+
+    size_t size() const override {
+        std::lock_guard<SpinLock> lock(combiner);
+        return cache->size();
+    }
+
+    void clear() override {
+        std::lock_guard<SpinLock> lock(combiner);
+        cache->clear();
+    }
+
+    MemoryUsage memory_usage() const override {
+        std::lock_guard<SpinLock> lock(combiner);
+        return cache->memory_usage();
+    }
+};
+
+#endif // CONCURRENT_CACHE_HPP
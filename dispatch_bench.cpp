@@ -0,0 +1,75 @@
+#include "arc_cache.hpp"
+#include "lru_cache.hpp"
+#include "lfu_cache.hpp"
+#include "workload.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Hit-path cost of calling a policy through the virtual Cache interface versus directly.
+// Build with -std=c++20 so the direct path is checked against the CachePolicy concept.
+
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+template<CachePolicy<int, int> Policy>
+#else
+template<typename Policy>
+#endif
+uint64_t replay_hits(Policy& cache, const std::vector<int>& keys, int rounds) {
+    uint64_t sum = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (int key : keys) {
+            int value;
+            if (cache.get(key, value)) sum += value;
+        }
+    }
+    return sum;
+}
+
+// Kept out of line so the compiler cannot see the dynamic type behind the reference
+__attribute__((noinline)) uint64_t replay_hits_virtual(Cache<int, int>& cache, const std::vector<int>& keys, int rounds) {
+    return replay_hits(cache, keys, rounds);
+}
+
+template<typename Policy>
+void run(const std::string& name, int capacity, const std::vector<int>& keys, int rounds) {
+    auto cache = std::make_unique<Policy>(capacity);
+    for (int i = 0; i < capacity; i++) {
+        cache->put(i, i);
+    }
+
+    // interleave the two paths and keep the best of several trials to filter out warm-up and noise
+    double ops = static_cast<double>(keys.size()) * rounds;
+    double virtual_ns = 1e300, direct_ns = 1e300;
+    uint64_t virtual_sum = 0, direct_sum = 0;
+    for (int trial = 0; trial < 5; trial++) {
+        auto start = std::chrono::steady_clock::now();
+        virtual_sum = replay_hits_virtual(*cache, keys, rounds);
+        auto middle = std::chrono::steady_clock::now();
+        direct_sum = replay_hits(*cache, keys, rounds);
+        auto end = std::chrono::steady_clock::now();
+        virtual_ns = std::min(virtual_ns, std::chrono::duration<double, std::nano>(middle - start).count() / ops);
+        direct_ns = std::min(direct_ns, std::chrono::duration<double, std::nano>(end - middle).count() / ops);
+    }
+    std::cout << name << "\t" << virtual_ns << "\t\t" << direct_ns << "\t\t"
+              << (virtual_ns / direct_ns - 1.0) * 100 << "%"
+              << (virtual_sum == direct_sum ? "" : "\t(checksum mismatch)") << "\n";
+}
+
+int main() {
+    const int CAPACITY = 1000; // small enough that the hit path stays in cache
+    const int ROUNDS = 50;
+    std::vector<int> keys(10000);
+    auto source = make_stream(ZipfianPattern(CAPACITY, 1.0), keys.size());
+    source.next_block(keys.data(), keys.size()); // every key is resident: all hits
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Cache\tvirtual (ns/op)\tdirect (ns/op)\tvirtual overhead\n";
+    run<ARCache<int, int>>("ARC", CAPACITY, keys, ROUNDS);
+    run<LRUCache<int, int>>("LRU", CAPACITY, keys, ROUNDS);
+    run<LFUCache<int, int>>("LFU", CAPACITY, keys, ROUNDS);
+    return 0;
+}
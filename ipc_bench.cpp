@@ -0,0 +1,128 @@
+#include "ipc_client.hpp"
+#include "ipc_server.hpp"
+#include "memcache_client.hpp"
+#include "memcache_server.hpp"
+#include "workload.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+// Round-trip latency of a cache hit from a co-located client: the memcached protocol over
+// loopback TCP, versus the shared-memory channel of IpcServer with the value copied out or
+// used in place. Every path checks the value it gets, so each touches the bytes once.
+
+std::string value_for(int key, size_t size) {
+    std::string value(size, '\0');
+    for (size_t i = 0; i < size; i++) value[i] = static_cast<char>('a' + (key + i) % 26);
+    return value;
+}
+
+struct Summary {
+    double mean, p50, p99;
+};
+
+// Times lookup(key) for every key; lookup returns false if the value was missing or wrong
+Summary measure(const std::vector<int>& keys, const std::function<bool(int)>& lookup, uint64_t& failures) {
+    std::vector<double> samples;
+    samples.reserve(keys.size());
+    for (int key : keys) {
+        auto t0 = std::chrono::steady_clock::now();
+        if (!lookup(key)) failures++;
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : samples) sum += sample;
+    return Summary{sum / samples.size(), samples[samples.size() / 2],
+                   samples[std::min(samples.size() - 1, samples.size() * 99 / 100)]};
+}
+
+int main(int argc, char** argv) {
+    int data_range = 4000;
+    size_t requests = 100000;
+    unsigned spin = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            data_range = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            requests = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--spin") == 0 && i + 1 < argc) {
+            spin = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+
+    MemcacheServerConfig tcp_config;
+    tcp_config.port = 0;
+    tcp_config.threads = 1;
+    tcp_config.memory_bytes = size_t(1) << 30;
+    IpcServerConfig ipc_config;
+    ipc_config.path = "/tmp/ipc_bench." + std::to_string(::getpid()) + ".sock";
+    ipc_config.arena_bytes = size_t(1) << 30;
+    ipc_config.spin = spin;
+
+    auto source = make_stream(RandomPattern(data_range), requests);
+    std::vector<int> keys = read_all(source);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Hits on " << data_range << " keys, " << requests << " requests per row, one client\n";
+    std::cout << "Value\tPath\t\t\tMean us\tp50 us\tp99 us\n";
+    try {
+        MemcacheServer tcp_server(tcp_config);
+        IpcServer ipc_server(ipc_config);
+        tcp_server.start();
+        ipc_server.start();
+        auto tcp = MemcacheClient::connect_tcp("127.0.0.1", tcp_server.port());
+        auto ipc = IpcClient::connect(ipc_config.path, spin);
+
+        uint64_t failures = 0;
+        for (size_t value_size : {100, 4000, 60000}) {
+            std::vector<std::string> values(data_range);
+            for (int key = 0; key < data_range; key++) {
+                values[key] = value_for(key, value_size);
+                tcp->set(std::to_string(key), values[key]);
+                if (!ipc->set(std::to_string(key), values[key])) failures++;
+            }
+            std::vector<std::pair<std::string, std::function<bool(int)>>> paths = {
+                {"TCP memcached\t", [&](int key) {
+                     std::string value;
+                     return tcp->get(std::to_string(key), value) && value == values[key];
+                 }},
+                {"IPC copy\t", [&](int key) {
+                     std::string value;
+                     return ipc->get(std::to_string(key), value) && value == values[key];
+                 }},
+                {"IPC zero-copy\t", [&](int key) {
+                     IpcValue value;
+                     if (!ipc->get(std::to_string(key), value)) return false;
+                     bool same = value.size() == values[key].size() &&
+                                 std::memcmp(value.data(), values[key].data(), value.size()) == 0;
+                     return value.valid() && same;
+                 }}
+            };
+            for (const auto& path : paths) {
+                Summary summary = measure(keys, path.second, failures);
+                std::cout << value_size << "\t" << path.first << "\t" << summary.mean << "\t" << summary.p50 << "\t"
+                          << summary.p99 << "\n";
+            }
+        }
+        if (failures) std::cerr << failures << " lookups missed or returned a wrong value\n";
+        ipc.reset();
+        tcp.reset();
+        ipc_server.stop();
+        tcp_server.stop();
+        std::cout << "IPC arena pages used: " << ipc_server.arena_pages() << ", moved: " << ipc_server.arena_pages_moved()
+                  << ", items: " << ipc_server.items() << "\n";
+        return failures ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef IPC_CHANNEL_HPP
+#define IPC_CHANNEL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Shared-memory layout used between IpcServer and IpcClient. Each client gets a channel in
+// its own memfd: a byte ring of requests (client to server) and a ring of fixed-size
+// responses (server to client), each single-producer single-consumer. All clients map the
+// server's value arena read-only; a hit is answered with the offset of the value there.
+
+enum class IpcOp : uint32_t { Get = 1, Set, Delete };
+enum class IpcStatus : uint32_t { Hit, Miss, Stored, NotStored, Deleted, NotFound };
+
+const uint64_t IPC_CHANNEL_MAGIC = 0x314c454e4e414843ULL; // "CHANNEL1"
+const uint32_t IPC_WRAP = 0; // record size marking the unused tail of the request ring
+
+// A request record in the byte ring: this header, the key, then the value, padded to 8 bytes
+struct IpcRequestHeader {
+    uint32_t record_bytes;
+    uint32_t op;
+    uint32_t key_size;
+    uint32_t value_size;
+};
+
+struct IpcResponse {
+    uint32_t status;
+    uint32_t value_size;
+    uint64_t offset;  // of the value in the arena, on a hit
+    uint64_t version; // the slot version the value was read under
+};
+
+// Every arena slot starts with this header. version is a seqlock: odd while the server
+// writes the slot, bumped again when it is done and when the slot is freed, so a reader
+// that sees the same even version before and after using the bytes saw a stable value.
+struct IpcSlotHeader {
+    std::atomic<uint64_t> version;
+    uint64_t reserved;
+};
+
+struct alignas(64) IpcChannel {
+    uint64_t magic;
+    uint64_t ring_bytes;     // size of the request ring
+    uint64_t response_slots; // size of the response ring
+    alignas(64) std::atomic<uint64_t> request_head;  // bytes produced, written by the client
+    alignas(64) std::atomic<uint64_t> request_tail;  // bytes consumed, written by the server
+    alignas(64) std::atomic<uint64_t> response_head; // written by the server
+    alignas(64) std::atomic<uint64_t> response_tail; // written by the client
+    // Set by a side before it blocks on the socket; the other side clears it and sends a byte
+    alignas(64) std::atomic<uint32_t> server_sleeping;
+    alignas(64) std::atomic<uint32_t> client_sleeping;
+
+    char* requests() { return reinterpret_cast<char*>(this + 1); }
+    IpcResponse* responses() { return reinterpret_cast<IpcResponse*>(requests() + ring_bytes); }
+
+    static size_t bytes_for(size_t ring_bytes, size_t response_slots) {
+        return sizeof(IpcChannel) + ring_bytes + response_slots * sizeof(IpcResponse);
+    }
+};
+
+#endif // IPC_CHANNEL_HPP
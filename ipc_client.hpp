@@ -0,0 +1,230 @@
+#ifndef IPC_CLIENT_HPP
+#define IPC_CLIENT_HPP
+
+#include "ipc_channel.hpp"
+#include "ipc_server.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// A value returned by reference into the server's arena. The bytes stay readable, but the
+// server may reuse the slot at any time: use them, then call valid(), and discard whatever
+// was derived from them if it returns false.
+class IpcValue {
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    const std::atomic<uint64_t>* version = nullptr;
+    uint64_t expected = 0;
+
+    friend class IpcClient;
+
+public:
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+    bool valid() const {
+        std::atomic_thread_fence(std::memory_order_acquire); // the reads of the bytes come first
+        return version->load(std::memory_order_relaxed) == expected;
+    }
+};
+
+// Client of IpcServer; one per thread. Each call is one round trip through the channel:
+// the request is written to the ring, the server is woken with a byte on the socket only
+// if it has gone to sleep, and the response is polled for `spin` rounds before blocking
+// on the socket. Errors throw.
+class IpcClient {
+private:
+    int fd;
+    IpcChannel* channel;
+    size_t channel_bytes;
+    const char* arena;
+    size_t arena_bytes;
+    unsigned spin;
+
+    IpcClient(int fd, IpcChannel* channel, size_t channel_bytes, const char* arena, size_t arena_bytes, unsigned spin)
+        : fd(fd), channel(channel), channel_bytes(channel_bytes), arena(arena), arena_bytes(arena_bytes), spin(spin) {}
+
+    static std::system_error error(const std::string& what) {
+        return std::system_error(errno, std::generic_category(), what);
+    }
+
+    static size_t record_bytes(size_t key_size, size_t value_size) {
+        return (sizeof(IpcRequestHeader) + key_size + value_size + 7) & ~size_t(7);
+    }
+
+    // Appends one request, or returns false if the ring lacks room for it now
+    bool push(IpcOp op, const std::string& key, const char* value, size_t value_size) {
+        size_t size = record_bytes(key.size(), value_size);
+        uint64_t ring_bytes = channel->ring_bytes;
+        uint64_t head = channel->request_head.load(std::memory_order_relaxed);
+        uint64_t tail = channel->request_tail.load(std::memory_order_acquire);
+        uint64_t at = head % ring_bytes;
+        uint64_t skip = ring_bytes - at < size ? ring_bytes - at : 0; // records never wrap
+        if (ring_bytes - (head - tail) < skip + size) return false;
+        char* ring = channel->requests();
+        if (skip) {
+            std::memcpy(ring + at, &IPC_WRAP, sizeof(IPC_WRAP));
+            at = 0;
+        }
+        IpcRequestHeader header{static_cast<uint32_t>(size), static_cast<uint32_t>(op),
+                                static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value_size)};
+        std::memcpy(ring + at, &header, sizeof(header));
+        std::memcpy(ring + at + sizeof(header), key.data(), key.size());
+        if (value_size) std::memcpy(ring + at + sizeof(header) + key.size(), value, value_size);
+        channel->request_head.store(head + skip + size, std::memory_order_seq_cst); // pairs with server_sleeping
+        return true;
+    }
+
+    void wait_byte() {
+        char byte;
+        while (true) {
+            ssize_t n = ::recv(fd, &byte, 1, 0);
+            if (n == 1) return;
+            if (n < 0 && errno == EINTR) continue;
+            if (n == 0) throw std::runtime_error("ipc: server closed the connection");
+            throw error("recv");
+        }
+    }
+
+    IpcResponse call(IpcOp op, const std::string& key, const char* value = nullptr, size_t value_size = 0) {
+        if (record_bytes(key.size(), value_size) > channel->ring_bytes / 2) {
+            throw std::invalid_argument("ipc: request larger than half the ring");
+        }
+        while (!push(op, key, value, value_size)) std::this_thread::yield(); // earlier requests still queued
+        if (channel->server_sleeping.load(std::memory_order_seq_cst) && channel->server_sleeping.exchange(0)) {
+            char byte = 0;
+            if (::send(fd, &byte, 1, MSG_NOSIGNAL) != 1) throw error("send");
+        }
+
+        uint64_t tail = channel->response_tail.load(std::memory_order_relaxed);
+        for (unsigned round = 0; channel->response_head.load(std::memory_order_acquire) == tail; round++) {
+            if (round < spin) {
+                std::this_thread::yield();
+                continue;
+            }
+            channel->client_sleeping.store(1, std::memory_order_seq_cst);
+            if (channel->response_head.load(std::memory_order_seq_cst) != tail) {
+                // Answered meanwhile: if the server already took the flag, its byte is on the way
+                if (!channel->client_sleeping.exchange(0)) wait_byte();
+                break;
+            }
+            wait_byte(); // the server clears the flag before it writes
+        }
+        IpcResponse response = channel->responses()[tail % channel->response_slots];
+        channel->response_tail.store(tail + 1, std::memory_order_release);
+        return response;
+    }
+
+    bool resolve(const IpcResponse& response, IpcValue& value) const {
+        if (response.offset < sizeof(IpcSlotHeader) || response.offset + response.value_size > arena_bytes) {
+            throw std::runtime_error("ipc: value reference outside the arena");
+        }
+        value.bytes = arena + response.offset;
+        value.length = response.value_size;
+        value.version = reinterpret_cast<const std::atomic<uint64_t>*>(arena + response.offset - sizeof(IpcSlotHeader));
+        value.expected = response.version;
+        return value.version->load(std::memory_order_acquire) == value.expected;
+    }
+
+public:
+    static std::unique_ptr<IpcClient> connect(const std::string& path, unsigned spin = 2000) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) throw std::invalid_argument("unix socket path too long");
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw error("socket");
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            std::system_error failure = error("connect to " + path);
+            ::close(fd);
+            throw failure;
+        }
+
+        // The hello carries the channel and arena descriptors
+        IpcHello hello{};
+        iovec iov{&hello, sizeof(hello)};
+        alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        ssize_t n;
+        do {
+            n = ::recvmsg(fd, &message, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+        } while (n < 0 && errno == EINTR);
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        if (n != static_cast<ssize_t>(sizeof(hello)) || hello.magic != IPC_CHANNEL_MAGIC || !header ||
+            header->cmsg_type != SCM_RIGHTS || header->cmsg_len != CMSG_LEN(2 * sizeof(int))) {
+            ::close(fd);
+            throw std::runtime_error("ipc: bad hello from " + path);
+        }
+        int fds[2];
+        std::memcpy(fds, CMSG_DATA(header), sizeof(fds));
+        void* channel = ::mmap(nullptr, hello.channel_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+        void* arena = ::mmap(nullptr, hello.arena_bytes, PROT_READ, MAP_SHARED, fds[1], 0);
+        ::close(fds[0]);
+        ::close(fds[1]);
+        if (channel == MAP_FAILED || arena == MAP_FAILED) {
+            std::system_error failure = error("mmap");
+            if (channel != MAP_FAILED) ::munmap(channel, hello.channel_bytes);
+            if (arena != MAP_FAILED) ::munmap(arena, hello.arena_bytes);
+            ::close(fd);
+            throw failure;
+        }
+        return std::unique_ptr<IpcClient>(new IpcClient(fd, static_cast<IpcChannel*>(channel), hello.channel_bytes,
+                                                        static_cast<const char*>(arena), hello.arena_bytes, spin));
+    }
+
+    ~IpcClient() {
+        ::munmap(channel, channel_bytes);
+        ::munmap(const_cast<char*>(arena), arena_bytes);
+        ::close(fd);
+    }
+
+    IpcClient(const IpcClient&) = delete;
+    IpcClient& operator=(const IpcClient&) = delete;
+
+    // Zero-copy lookup: on a hit, value refers to the bytes in the arena (see IpcValue)
+    bool get(const std::string& key, IpcValue& value) {
+        while (true) {
+            IpcResponse response = call(IpcOp::Get, key);
+            if (response.status != static_cast<uint32_t>(IpcStatus::Hit)) return false;
+            if (resolve(response, value)) return true;
+            // Replaced between the lookup and now: ask again
+        }
+    }
+
+    // Copying lookup, for callers that keep the value
+    bool get(const std::string& key, std::string& value) {
+        IpcValue ref;
+        while (get(key, ref)) {
+            value.assign(ref.data(), ref.size());
+            if (ref.valid()) return true;
+        }
+        return false;
+    }
+
+    // Returns false if the server could not store the value (too large, or no room)
+    bool set(const std::string& key, const std::string& value) {
+        return call(IpcOp::Set, key, value.data(), value.size()).status == static_cast<uint32_t>(IpcStatus::Stored);
+    }
+
+    bool erase(const std::string& key) {
+        return call(IpcOp::Delete, key).status == static_cast<uint32_t>(IpcStatus::Deleted);
+    }
+};
+
+#endif // IPC_CLIENT_HPP
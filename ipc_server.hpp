@@ -0,0 +1,548 @@
+#ifndef IPC_SERVER_HPP
+#define IPC_SERVER_HPP
+
+#include "arc_cache.hpp"
+#include "ipc_channel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Sent by the server with the channel and arena descriptors when a client connects
+struct IpcHello {
+    uint64_t magic;
+    uint64_t channel_bytes;
+    uint64_t arena_bytes;
+};
+
+// Value storage shared read-only with every client: a memfd cut into slots of power-of-two
+// classes from 64 bytes to one 1 MB page, each an IpcSlotHeader followed by the value.
+// Pages are given to classes on demand. Once all are given out, a class that eviction does
+// not help takes the page with the fewest used slots from another class and cuts it anew;
+// the new slot headers start above every version handed out, so a client still holding a
+// reference into the old layout sees its version change (unless value bytes now at its
+// header happen to equal it). Only the server thread touches the free lists.
+class ValueArena {
+public:
+    static constexpr size_t PAGE_BYTES = 1 << 20;
+    static constexpr size_t MIN_SLOT = 64;
+
+    struct Slot {
+        uint64_t offset; // of the slot header
+        uint8_t cls;
+    };
+
+private:
+    static constexpr size_t NUM_CLASSES = 15; // 64 B .. 1 MB
+
+    int memfd;
+    char* base;
+    size_t bytes;
+    size_t num_pages;
+    size_t pages_used;
+    struct Page {
+        size_t used; // slots holding a value
+        uint8_t cls;
+    };
+
+    std::vector<std::vector<uint64_t>> free_slots;
+    std::vector<size_t> class_pages;
+    std::vector<Page> pages;
+    uint64_t top_version; // highest version written so far
+    size_t pages_moved;
+
+    static size_t slot_bytes(uint8_t cls) { return MIN_SLOT << cls; }
+
+    IpcSlotHeader& header(uint64_t offset) { return *reinterpret_cast<IpcSlotHeader*>(base + offset); }
+
+    void assign(size_t p, uint8_t cls) {
+        pages[p] = Page{0, cls};
+        class_pages[cls]++;
+        uint64_t page = p * PAGE_BYTES;
+        for (uint64_t at = page + PAGE_BYTES; at > page; at -= slot_bytes(cls)) {
+            header(at - slot_bytes(cls)).version.store(top_version, std::memory_order_relaxed);
+            free_slots[cls].push_back(at - slot_bytes(cls));
+        }
+    }
+
+    bool take(uint8_t cls, Slot& slot) {
+        auto& free = free_slots[cls];
+        if (free.empty()) {
+            if (pages_used == num_pages) return false;
+            assign(pages_used++, cls);
+        }
+        slot = Slot{free.back(), cls};
+        free.pop_back();
+        pages[slot.offset / PAGE_BYTES].used++;
+        return true;
+    }
+
+    // Gives cls the page with the fewest used slots of another class, calling release(offset)
+    // for each of its slots (which must free() the slot if it is in use). Returns false if
+    // every page already belongs to cls.
+    template<typename Release>
+    bool move_page(uint8_t cls, Release release) {
+        size_t donor = num_pages;
+        for (size_t p = 0; p < pages_used; p++) {
+            if (pages[p].cls != cls && (donor == num_pages || pages[p].used < pages[donor].used)) donor = p;
+        }
+        if (donor == num_pages) return false;
+        uint8_t from = pages[donor].cls;
+        uint64_t page = donor * PAGE_BYTES;
+        for (uint64_t at = page; at < page + PAGE_BYTES && pages[donor].used; at += slot_bytes(from)) release(at);
+        auto& free = free_slots[from];
+        free.erase(std::remove_if(free.begin(), free.end(),
+                                  [page](uint64_t at) { return at >= page && at < page + PAGE_BYTES; }),
+                   free.end());
+        class_pages[from]--;
+        assign(donor, cls);
+        pages_moved++;
+        return true;
+    }
+
+public:
+    explicit ValueArena(size_t arena_bytes)
+        : memfd(-1), base(nullptr), bytes(arena_bytes / PAGE_BYTES * PAGE_BYTES), num_pages(bytes / PAGE_BYTES),
+          pages_used(0), free_slots(NUM_CLASSES), class_pages(NUM_CLASSES, 0), pages(num_pages),
+          top_version(0), pages_moved(0) {
+        if (num_pages == 0) throw std::invalid_argument("value arena must hold at least one page");
+        memfd = ::memfd_create("arc-values", MFD_CLOEXEC);
+        if (memfd < 0) throw std::system_error(errno, std::generic_category(), "memfd_create");
+        if (::ftruncate(memfd, static_cast<off_t>(bytes)) != 0) {
+            int saved = errno;
+            ::close(memfd);
+            throw std::system_error(saved, std::generic_category(), "ftruncate");
+        }
+        void* mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+        if (mapped == MAP_FAILED) {
+            int saved = errno;
+            ::close(memfd);
+            throw std::system_error(saved, std::generic_category(), "mmap");
+        }
+        base = static_cast<char*>(mapped);
+    }
+
+    ~ValueArena() {
+        ::munmap(base, bytes);
+        ::close(memfd);
+    }
+
+    ValueArena(const ValueArena&) = delete;
+    ValueArena& operator=(const ValueArena&) = delete;
+
+    int fd() const { return memfd; }
+    size_t size() const { return bytes; }
+    size_t max_value() const { return PAGE_BYTES - sizeof(IpcSlotHeader); }
+    size_t used_pages() const { return pages_used; }
+    size_t moved_pages() const { return pages_moved; }
+
+    // A slot for value_size bytes. While the class is out of slots it calls evict() (which
+    // returns false when there is nothing left to evict) once if the class owns pages; if that
+    // frees no slot of the class, or the class owns none, it moves a page over from another
+    // class (see move_page for release).
+    template<typename Evict, typename Release>
+    bool alloc(size_t value_size, Slot& slot, Evict evict, Release release) {
+        size_t need = value_size + sizeof(IpcSlotHeader);
+        if (need > PAGE_BYTES) return false;
+        uint8_t cls = 0;
+        while (slot_bytes(cls) < need) cls++;
+        if (take(cls, slot)) return true;
+        if (class_pages[cls] > 0 && evict() && take(cls, slot)) return true;
+        // The victim held a slot of another class, which is therefore colder: take a page instead
+        return move_page(cls, release) && take(cls, slot);
+    }
+
+    // Fills a slot and returns the version readers must see around their reads
+    uint64_t write(const Slot& slot, const char* data, size_t size) {
+        IpcSlotHeader& h = header(slot.offset);
+        uint64_t version = h.version.load(std::memory_order_relaxed);
+        h.version.store(version + 1, std::memory_order_relaxed); // odd: being written
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(base + slot.offset + sizeof(IpcSlotHeader), data, size);
+        h.version.store(version + 2, std::memory_order_release);
+        top_version = std::max(top_version, version + 2);
+        return version + 2;
+    }
+
+    // Readers still holding the slot's old version will see it change
+    void free(const Slot& slot) {
+        uint64_t version = header(slot.offset).version.fetch_add(2, std::memory_order_release) + 2;
+        top_version = std::max(top_version, version);
+        free_slots[slot.cls].push_back(slot.offset);
+        pages[slot.offset / PAGE_BYTES].used--;
+    }
+};
+
+struct IpcServerConfig {
+    std::string path;                      // Unix socket, for setup and wakeups only
+    size_t arena_bytes = size_t(64) << 20; // values, shared read-only with the clients
+    size_t capacity = 0;                   // entries; 0 means arena_bytes / 64
+    size_t ring_bytes = 1 << 20;           // request ring per client
+    size_t response_slots = 1024;          // response ring per client
+    unsigned spin = 2000;                  // idle polls of the rings before blocking
+};
+
+// Local-client front end for ARCache. A client connects to the Unix socket and receives a
+// memfd holding its channel (request and response rings, see ipc_channel.hpp) and the
+// arena memfd, which it maps read-only. From then on requests and responses only go
+// through shared memory, and a hit is answered with a reference into the arena rather
+// than a copy. One server thread serves every channel: it polls them while there is work,
+// and after `spin` idle rounds marks itself asleep and blocks in epoll on the client
+// sockets, where a client that finds it asleep writes one byte. The client does the same
+// while it waits for its response.
+class IpcServer {
+private:
+    struct Entry {
+        ValueArena::Slot slot;
+        uint32_t size;
+        uint64_t version;
+    };
+
+    struct Client {
+        int fd;
+        IpcChannel* channel;
+        size_t channel_bytes;
+    };
+
+    IpcServerConfig config;
+    ValueArena arena;
+    ARCache<std::string, Entry> engine;
+    std::unordered_map<uint64_t, std::string> owners; // slot offset -> key, to empty a page that changes class
+    size_t channel_bytes;
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;
+    std::unordered_map<int, Client> clients;
+    std::atomic<bool> stopping;
+    unsigned busy_rounds;
+    std::thread thread;
+
+    static std::system_error error(const std::string& what) {
+        return std::system_error(errno, std::generic_category(), what);
+    }
+
+    void watch(int fd) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) throw error("epoll_ctl");
+    }
+
+    void accept_all() {
+        while (true) {
+            int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            int memfd = ::memfd_create("arc-channel", MFD_CLOEXEC);
+            void* mapped = MAP_FAILED;
+            if (memfd >= 0 && ::ftruncate(memfd, static_cast<off_t>(channel_bytes)) == 0) {
+                mapped = ::mmap(nullptr, channel_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+            }
+            if (mapped == MAP_FAILED) {
+                if (memfd >= 0) ::close(memfd);
+                ::close(fd);
+                continue;
+            }
+            IpcChannel* channel = new (mapped) IpcChannel();
+            channel->magic = IPC_CHANNEL_MAGIC;
+            channel->ring_bytes = config.ring_bytes;
+            channel->response_slots = config.response_slots;
+
+            IpcHello hello{IPC_CHANNEL_MAGIC, channel_bytes, arena.size()};
+            int fds[2] = {memfd, arena.fd()};
+            bool sent = send_fds(fd, hello, fds);
+            ::close(memfd); // the mapping and the client's copy keep it alive
+            if (!sent) {
+                ::munmap(mapped, channel_bytes);
+                ::close(fd);
+                continue;
+            }
+            clients.emplace(fd, Client{fd, channel, channel_bytes});
+            watch(fd);
+        }
+    }
+
+    static bool send_fds(int socket, const IpcHello& hello, const int (&fds)[2]) {
+        iovec iov{const_cast<IpcHello*>(&hello), sizeof(hello)};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(fds));
+        std::memcpy(CMSG_DATA(header), fds, sizeof(fds));
+        // The socket is fresh, so the hello fits in its buffer
+        return ::sendmsg(socket, &message, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(hello));
+    }
+
+    void disconnect(int fd) {
+        auto it = clients.find(fd);
+        if (it == clients.end()) return;
+        ::munmap(it->second.channel, it->second.channel_bytes);
+        ::close(fd);
+        clients.erase(it);
+    }
+
+    // Wake-up bytes carry no data; EOF means the client is gone
+    void drain(int fd) {
+        char buffer[64];
+        while (true) {
+            ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n > 0) continue;
+            if (n < 0 && errno == EINTR) continue;
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) disconnect(fd);
+            return;
+        }
+    }
+
+    void release_slot(const ValueArena::Slot& slot) {
+        owners.erase(slot.offset);
+        arena.free(slot);
+    }
+
+    // Drops the entry whose value is in the slot at offset, if any
+    void vacate(uint64_t offset) {
+        auto it = owners.find(offset);
+        if (it == owners.end()) return;
+        std::string key = std::move(it->second);
+        release_slot(engine.peek(key)->slot);
+        engine.erase(key);
+    }
+
+    IpcResponse handle(IpcOp op, const std::string& key, const char* value, size_t value_size) {
+        IpcResponse response{};
+        switch (op) {
+        case IpcOp::Get: {
+            Entry entry;
+            if (!engine.get(key, entry)) {
+                response.status = static_cast<uint32_t>(IpcStatus::Miss);
+                break;
+            }
+            response.status = static_cast<uint32_t>(IpcStatus::Hit);
+            response.value_size = entry.size;
+            response.offset = entry.slot.offset + sizeof(IpcSlotHeader);
+            response.version = entry.version;
+            break;
+        }
+        case IpcOp::Set: {
+            ValueArena::Slot slot;
+            if (!arena.alloc(value_size, slot, [this] { return engine.evict_one(); },
+                             [this](uint64_t offset) { vacate(offset); })) {
+                response.status = static_cast<uint32_t>(IpcStatus::NotStored);
+                break;
+            }
+            if (Entry* old = engine.peek(key)) release_slot(old->slot); // unless evicted just now
+            uint64_t version = arena.write(slot, value, value_size);
+            owners[slot.offset] = key;
+            engine.put(key, Entry{slot, static_cast<uint32_t>(value_size), version});
+            response.status = static_cast<uint32_t>(IpcStatus::Stored);
+            break;
+        }
+        case IpcOp::Delete: {
+            Entry* old = engine.peek(key);
+            if (!old) {
+                response.status = static_cast<uint32_t>(IpcStatus::NotFound);
+                break;
+            }
+            release_slot(old->slot);
+            engine.erase(key);
+            response.status = static_cast<uint32_t>(IpcStatus::Deleted);
+            break;
+        }
+        }
+        return response;
+    }
+
+    // Serves the requests pending on one channel; returns false if there were none. A
+    // malformed record disconnects the client.
+    bool serve(Client& client) {
+        IpcChannel& channel = *client.channel;
+        uint64_t tail = channel.request_tail.load(std::memory_order_relaxed);
+        uint64_t head = channel.request_head.load(std::memory_order_acquire);
+        if (tail == head) return false;
+        uint64_t response_head = channel.response_head.load(std::memory_order_relaxed);
+        uint64_t response_tail = channel.response_tail.load(std::memory_order_acquire);
+        const char* ring = channel.requests();
+        bool broken = false;
+        while (tail != head) {
+            if (response_head - response_tail == config.response_slots) {
+                response_tail = channel.response_tail.load(std::memory_order_acquire);
+                if (response_head - response_tail == config.response_slots) break; // client is behind
+            }
+            uint64_t at = tail % config.ring_bytes;
+            IpcRequestHeader request;
+            std::memcpy(&request, ring + at, sizeof(uint32_t));
+            if (request.record_bytes == IPC_WRAP) {
+                tail += config.ring_bytes - at;
+                continue;
+            }
+            std::memcpy(&request, ring + at, sizeof(request));
+            uint64_t payload = uint64_t(request.key_size) + request.value_size;
+            if (request.record_bytes < sizeof(request) + payload || request.record_bytes > config.ring_bytes - at ||
+                request.op < static_cast<uint32_t>(IpcOp::Get) || request.op > static_cast<uint32_t>(IpcOp::Delete)) {
+                broken = true;
+                break;
+            }
+            std::string key(ring + at + sizeof(request), request.key_size);
+            channel.responses()[response_head % config.response_slots] =
+                handle(static_cast<IpcOp>(request.op), key, ring + at + sizeof(request) + request.key_size,
+                       request.value_size);
+            response_head++;
+            tail += request.record_bytes;
+        }
+        channel.request_tail.store(tail, std::memory_order_release);
+        channel.response_head.store(response_head, std::memory_order_seq_cst); // pairs with client_sleeping
+        if (channel.client_sleeping.load(std::memory_order_seq_cst) && channel.client_sleeping.exchange(0)) {
+            char byte = 0;
+            (void)!::send(client.fd, &byte, 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+        }
+        if (broken) disconnect(client.fd);
+        return true;
+    }
+
+    // Handles socket events: accepts, wake-up bytes and disconnects. Blocks up to timeout ms.
+    void poll_sockets(int timeout) {
+        epoll_event events[64];
+        int n = ::epoll_wait(epoll_fd, events, 64, timeout);
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd) {
+                accept_all();
+            } else if (fd != wake_fd) {
+                drain(fd);
+            }
+        }
+    }
+
+    bool any_pending() {
+        for (auto& entry : clients) {
+            IpcChannel& channel = *entry.second.channel;
+            if (channel.request_head.load(std::memory_order_seq_cst) != channel.request_tail.load(std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run() {
+        unsigned idle = 0;
+        std::vector<int> fds;
+        while (!stopping.load(std::memory_order_acquire)) {
+            fds.clear();
+            for (auto& entry : clients) fds.push_back(entry.first);
+            bool busy = false;
+            for (int fd : fds) {
+                auto it = clients.find(fd);
+                if (it != clients.end()) busy |= serve(it->second);
+            }
+            if (busy) {
+                idle = 0;
+                if ((++busy_rounds & 255) == 0) poll_sockets(0); // let new clients in under load
+                continue;
+            }
+            if (++idle < config.spin) {
+                std::this_thread::yield();
+                continue;
+            }
+            // Going to sleep: a client that sees the flag will write a byte to its socket
+            for (auto& entry : clients) entry.second.channel->server_sleeping.store(1, std::memory_order_seq_cst);
+            poll_sockets(any_pending() ? 0 : -1);
+            for (auto& entry : clients) entry.second.channel->server_sleeping.store(0, std::memory_order_relaxed);
+            idle = 0;
+        }
+    }
+
+    void release() {
+        for (auto& entry : clients) {
+            ::munmap(entry.second.channel, entry.second.channel_bytes);
+            ::close(entry.first);
+        }
+        clients.clear();
+        if (listen_fd >= 0) {
+            ::close(listen_fd);
+            ::unlink(config.path.c_str());
+        }
+        if (wake_fd >= 0) ::close(wake_fd);
+        if (epoll_fd >= 0) ::close(epoll_fd);
+        listen_fd = wake_fd = epoll_fd = -1;
+    }
+
+public:
+    explicit IpcServer(const IpcServerConfig& config)
+        : config(config), arena(config.arena_bytes),
+          engine(config.capacity ? config.capacity : config.arena_bytes / ValueArena::MIN_SLOT),
+          channel_bytes(IpcChannel::bytes_for(config.ring_bytes, config.response_slots)),
+          listen_fd(-1), epoll_fd(-1), wake_fd(-1), stopping(false), busy_rounds(0) {
+        if (config.ring_bytes % 8 != 0 || config.ring_bytes < 64 || config.response_slots == 0) {
+            throw std::invalid_argument("ipc server: ring_bytes must be a multiple of 8, response_slots nonzero");
+        }
+        engine.set_eviction_callback([this](const std::string&, const Entry& entry) { release_slot(entry.slot); });
+        try {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            if (config.path.size() >= sizeof(addr.sun_path)) throw std::invalid_argument("unix socket path too long");
+            std::memcpy(addr.sun_path, config.path.c_str(), config.path.size() + 1);
+            listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (listen_fd < 0) throw error("socket");
+            ::unlink(config.path.c_str()); // a stale socket from an earlier run
+            if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+                ::listen(listen_fd, SOMAXCONN) != 0) {
+                throw error("bind/listen on " + config.path);
+            }
+            epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+            wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (epoll_fd < 0 || wake_fd < 0) throw error("epoll/eventfd");
+            watch(listen_fd);
+            watch(wake_fd);
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    ~IpcServer() {
+        stop();
+        release();
+    }
+
+    IpcServer(const IpcServer&) = delete;
+    IpcServer& operator=(const IpcServer&) = delete;
+
+    void start() {
+        if (!thread.joinable()) thread = std::thread([this] { run(); });
+    }
+
+    void stop() {
+        stopping.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        if (wake_fd >= 0) (void)!::write(wake_fd, &one, sizeof(one));
+        if (thread.joinable()) thread.join();
+    }
+
+    // Only while the server thread is not running
+    size_t items() const { return engine.size(); }
+    size_t arena_pages() const { return arena.used_pages(); }
+    size_t arena_pages_moved() const { return arena.moved_pages(); }
+};
+
+#endif // IPC_SERVER_HPP
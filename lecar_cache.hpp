@@ -0,0 +1,253 @@
+#ifndef LECAR_CACHE_HPP
+#define LECAR_CACHE_HPP
+
+#include "cache.hpp"
+#include <unordered_map>
+#include <list>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+// Learned weights of the two experts, exposed through LeCaRCache::stats()
+struct LeCaRStats {
+    double lru_weight = 0.5;
+    double lfu_weight = 0.5;
+    uint64_t lru_evictions = 0;
+    uint64_t lfu_evictions = 0;
+    uint64_t lru_regrets = 0; // misses on keys the LRU expert evicted
+    uint64_t lfu_regrets = 0;
+};
+
+// LeCaR (Vietri et al., HotStorage 2018): LRU and LFU run as experts over one shared set
+// of resident keys. Each eviction is made by an expert drawn at random by weight, and the
+// victim goes into that expert's history. A miss on a key found in a history is a regret
+// for the expert that evicted it, and shifts weight to the other one by multiplicative
+// weights, discounted by how long ago the eviction happened. A key readmitted from a
+// history gets back the frequency it was evicted with, so the LFU expert keeps hot keys
+// that one of the experts got wrong. Hits and new keys are O(1); a readmitted key whose
+// frequency no resident key shares walks the buckets below it to find its place.
+template<typename K, typename V>
+class LeCaRCache final : public Cache<K, V> {
+private:
+    using KeyList = std::list<K, CountingAllocator<K>>;
+
+    struct FreqNode { // one frequency bucket: all keys with this frequency, front most recent
+        uint64_t freq;
+        KeyList keys;
+    };
+    using FreqList = std::list<FreqNode, CountingAllocator<FreqNode>>;
+
+    struct Entry {
+        V value;
+        typename KeyList::iterator lru_pos;
+        typename FreqList::iterator bucket;
+        typename KeyList::iterator bucket_pos;
+    };
+
+    template<typename T>
+    using Map = std::unordered_map<K, T, std::hash<K>, std::equal_to<K>, CountingAllocator<std::pair<const K, T>>>;
+
+    struct Evicted {
+        K key;
+        uint64_t time;
+        uint64_t freq;
+    };
+
+    // Keys an expert evicted, oldest first, with the time and frequency of eviction
+    struct History {
+        using Order = std::list<Evicted, CountingAllocator<Evicted>>;
+        Order order;
+        Map<typename Order::iterator> index;
+
+        explicit History(MemoryCounter* bytes) : order(CountingAllocator<K>(bytes)), index(CountingAllocator<K>(bytes)) {}
+
+        void add(const K& key, uint64_t time, uint64_t freq, size_t limit) {
+            order.push_back(Evicted{key, time, freq});
+            index[key] = std::prev(order.end());
+            if (order.size() > limit) {
+                index.erase(order.front().key);
+                order.pop_front();
+            }
+        }
+
+        // Removes key and returns its eviction time and frequency, or returns false when absent
+        bool take(const K& key, uint64_t& time, uint64_t& freq) {
+            auto it = index.find(key);
+            if (it == index.end()) return false;
+            time = it->second->time;
+            freq = it->second->freq;
+            order.erase(it->second);
+            index.erase(it);
+            return true;
+        }
+
+        void clear() {
+            index.clear();
+            order.clear();
+        }
+    };
+
+    size_t capacity;
+    double learning_rate;
+    double discount;   // reward decay per unit of time, 0.005^(1/capacity)
+    uint64_t time;     // advances on every lookup
+    LeCaRStats counters;
+    std::mt19937 gen;
+
+    MemoryCounter entry_bytes; // declared before the containers that report to them
+    MemoryCounter index_bytes;
+    MemoryCounter ghost_bytes;
+
+    Map<Entry> entries;
+    KeyList lru;         // front is the most recently used
+    FreqList freqs;      // ascending frequency, front is the minimum
+    std::unordered_map<uint64_t, typename FreqList::iterator, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                       CountingAllocator<std::pair<const uint64_t, typename FreqList::iterator>>>
+        buckets;         // freq -> its node in freqs
+    History lru_history;
+    History lfu_history;
+
+    // Inserts the bucket for freq before pos
+    typename FreqList::iterator add_bucket(typename FreqList::iterator pos, uint64_t freq) {
+        auto bucket = freqs.insert(pos, FreqNode{freq, KeyList(CountingAllocator<K>(&index_bytes))});
+        buckets.emplace(freq, bucket);
+        return bucket;
+    }
+
+    void drop_if_empty(typename FreqList::iterator bucket) {
+        if (!bucket->keys.empty()) return;
+        buckets.erase(bucket->freq);
+        freqs.erase(bucket);
+    }
+
+    // The bucket for freq, created in order if no resident key has that frequency
+    typename FreqList::iterator bucket_for(uint64_t freq) {
+        auto found = buckets.find(freq);
+        if (found != buckets.end()) return found->second;
+        auto pos = freqs.begin();
+        while (pos != freqs.end() && pos->freq < freq) ++pos;
+        return add_bucket(pos, freq);
+    }
+
+    void bump(Entry& entry) {
+        lru.splice(lru.begin(), lru, entry.lru_pos);
+
+        auto bucket = entry.bucket;
+        auto next = std::next(bucket);
+        if (next == freqs.end() || next->freq != bucket->freq + 1) {
+            next = add_bucket(next, bucket->freq + 1);
+        }
+        next->keys.splice(next->keys.begin(), bucket->keys, entry.bucket_pos);
+        entry.bucket = next;
+        entry.bucket_pos = next->keys.begin();
+        drop_if_empty(bucket);
+    }
+
+    void erase_entry(typename Map<Entry>::iterator it) {
+        Entry& entry = it->second;
+        lru.erase(entry.lru_pos);
+        entry.bucket->keys.erase(entry.bucket_pos);
+        drop_if_empty(entry.bucket);
+        entries.erase(it);
+    }
+
+    void reward(double& weight, uint64_t evicted_at) {
+        weight *= std::exp(learning_rate * std::pow(discount, static_cast<double>(time - evicted_at)));
+        double total = counters.lru_weight + counters.lfu_weight;
+        counters.lru_weight /= total;
+        counters.lfu_weight /= total;
+    }
+
+    void evict() {
+        bool use_lru = std::uniform_real_distribution<double>(0.0, 1.0)(gen) < counters.lru_weight;
+        K victim = use_lru ? lru.back() : freqs.front().keys.back(); // LFU ties go to the least recent
+        auto it = entries.find(victim);
+        uint64_t freq = it->second.bucket->freq;
+        erase_entry(it);
+        if (use_lru) {
+            lru_history.add(victim, time, freq, capacity);
+            counters.lru_evictions++;
+        } else {
+            lfu_history.add(victim, time, freq, capacity);
+            counters.lfu_evictions++;
+        }
+    }
+
+public:
+    explicit LeCaRCache(size_t size, double learning_rate = 0.45, uint32_t seed = 42)
+        : capacity(size), learning_rate(learning_rate),
+          discount(std::pow(0.005, 1.0 / static_cast<double>(std::max<size_t>(1, size)))), time(0), gen(seed),
+          entries(CountingAllocator<K>(&entry_bytes)), lru(CountingAllocator<K>(&index_bytes)),
+          freqs(CountingAllocator<K>(&index_bytes)), buckets(CountingAllocator<K>(&index_bytes)), lru_history(&ghost_bytes), lfu_history(&ghost_bytes) {}
+
+    void put(const K& key, const V& value) override {
+        if (capacity == 0) return;
+
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            it->second.value = value;
+            bump(it->second);
+            return;
+        }
+
+        uint64_t evicted_at, freq = 0;
+        if (lru_history.take(key, evicted_at, freq)) { // LRU should not have evicted it
+            counters.lru_regrets++;
+            reward(counters.lfu_weight, evicted_at);
+        } else if (lfu_history.take(key, evicted_at, freq)) {
+            counters.lfu_regrets++;
+            reward(counters.lru_weight, evicted_at);
+        }
+
+        if (entries.size() >= capacity) {
+            evict();
+        }
+
+        auto bucket = bucket_for(freq + 1); // a new key starts at 1, a readmitted one counts this access too
+        lru.push_front(key);
+        bucket->keys.push_front(key);
+        entries.emplace(key, Entry{value, lru.begin(), bucket, bucket->keys.begin()});
+    }
+
+    bool get(const K& key, V& value) override {
+        time++;
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            return false;
+        }
+        value = it->second.value;
+        bump(it->second);
+        return true;
+    }
+
+    size_t size() const override {
+        return entries.size();
+    }
+
+    void clear() override {
+        entries.clear();
+        lru.clear();
+        freqs.clear();
+        buckets.clear();
+        lru_history.clear();
+        lfu_history.clear();
+        counters = LeCaRStats();
+        time = 0;
+    }
+
+    LeCaRStats stats() const {
+        return counters;
+    }
+
+    MemoryUsage memory_usage() const override {
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.ghosts = ghost_bytes.bytes;
+        usage.index = index_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead + ghost_bytes.overhead + index_bytes.overhead;
+        return usage;
+    }
+};
+
+#endif // LECAR_CACHE_HPP
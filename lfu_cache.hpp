@@ -4,15 +4,37 @@
 #include "cache.hpp"
 #include <unordered_map>
 #include <map>
+#include <scoped_allocator>
 
 template<typename K, typename V>
-class LFUCache : public Cache<K, V> {
+class LFUCache final : public Cache<K, V> {
 private:
+    using KeyList = std::list<K, CountingAllocator<K>>;
+    template<typename T>
+    using Map = std::unordered_map<K, T, std::hash<K>, std::equal_to<K>, CountingAllocator<std::pair<const K, T>>>;
+    // the scoped adaptor hands the counting allocator down to each per-frequency list
+    using FreqMap = std::map<size_t, KeyList, std::less<size_t>,
+                             std::scoped_allocator_adaptor<CountingAllocator<std::pair<const size_t, KeyList>>>>;
+
     size_t capacity; //the maximum elements in cache
     size_t minFreq; //element with the minimum frequency
-    std::unordered_map<K, std::pair<V, size_t>> keyToVal;  // key -> {value, freq}
-    std::unordered_map<K, typename std::list<K>::iterator> keyToIter;  // key -> iterator in freqToKeys
-    std::map<size_t, std::list<K>> freqToKeys;  // freq -> list of keys with the same frequency
+    MemoryCounter entry_bytes; // declared before the containers that report to them
+    MemoryCounter index_bytes;
+    Map<std::pair<V, size_t>> keyToVal;  // key -> {value, freq}
+    Map<typename KeyList::iterator> keyToIter;  // key -> iterator in freqToKeys
+    FreqMap freqToKeys;  // freq -> list of keys with the same frequency
+
+    // Drops the least recently used key of the lowest frequency
+    void evict() {
+        K evictKey = freqToKeys[minFreq].back();
+        freqToKeys[minFreq].pop_back(); //evict the minimum frequency element
+        if (freqToKeys[minFreq].empty()) {
+            freqToKeys.erase(minFreq);
+            if (!freqToKeys.empty()) minFreq = freqToKeys.begin()->first;
+        } //if the list of minFreq is empty
+        keyToVal.erase(evictKey);
+        keyToIter.erase(evictKey);
+    }
 
     void increment(const K& key) {
         size_t freq = keyToVal[key].second;
@@ -31,10 +53,13 @@ private:
     }
 
 public:
-    explicit LFUCache(size_t size) : capacity(size), minFreq(0) {}
+    explicit LFUCache(size_t size)
+        : capacity(size), minFreq(0), keyToVal(CountingAllocator<int>(&entry_bytes)),
+          keyToIter(CountingAllocator<int>(&index_bytes)), freqToKeys(CountingAllocator<int>(&index_bytes)) {}
 
     void put(const K& key, const V& value) override {
         if (capacity == 0) return;
+        shrink(RESIZE_STEP);
 
         if (keyToVal.count(key)) {
             keyToVal[key].first = value;
@@ -43,13 +68,7 @@ public:
         }
 
         if (keyToVal.size() >= capacity) {
-            K evictKey = freqToKeys[minFreq].back();
-            freqToKeys[minFreq].pop_back(); //evict the minimum frequency element
-            if (freqToKeys[minFreq].empty()) {
-                freqToKeys.erase(minFreq);
-            } //if the list of minFreq is empty
-            keyToVal.erase(evictKey);
-            keyToIter.erase(evictKey);
+            evict();
         }
 
         keyToVal[key] = {value, 1};
@@ -59,6 +78,7 @@ public:
     }
 
     bool get(const K& key, V& value) override {
+        shrink(RESIZE_STEP);
         if (keyToVal.count(key) == 0) {
             return false;
         }
@@ -71,12 +91,37 @@ public:
         return keyToVal.size();
     }
 
+    // Growing takes effect at once. Shrinking evicts the surplus RESIZE_STEP entries per later
+    // put()/get(), lowest frequency first, so size() can exceed the capacity for a while;
+    // resize(0) clears at once.
+    void resize(size_t new_capacity) {
+        if (new_capacity == 0) clear();
+        capacity = new_capacity;
+    }
+
+    // Evicts up to budget surplus entries now instead of on later calls; returns true while
+    // the cache is still above its capacity
+    bool shrink(size_t budget) {
+        for (; budget > 0 && keyToVal.size() > capacity; budget--) {
+            evict();
+        }
+        return keyToVal.size() > capacity;
+    }
+
     void clear() override {
         keyToVal.clear();
         keyToIter.clear();
         freqToKeys.clear();
         minFreq = 0;
     }
+
+    MemoryUsage memory_usage() const override {
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.index = index_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead + index_bytes.overhead;
+        return usage;
+    }
 };
 
 #endif // LFU_CACHE_HPP
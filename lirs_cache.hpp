@@ -0,0 +1,207 @@
+#ifndef LIRS_CACHE_HPP
+#define LIRS_CACHE_HPP
+
+#include "cache.hpp"
+#include <unordered_map>
+#include <list>
+#include <algorithm>
+
+// LIRS (Jiang & Zhang, SIGMETRICS 2002). Blocks with a short inter-reference recency (LIR)
+// hold ~99% of the cache; the rest is a small queue Q of resident HIR blocks, so a loop
+// larger than the cache only churns Q instead of flushing the LIR set.
+// The stack S orders blocks by recency and keeps its bottom a LIR block (pruning).
+// Non-resident HIR blocks in S are bounded to `capacity` records; the oldest is dropped first.
+// At capacity 1 there is no room for a LIR set: the one block is a resident HIR block and
+// is never promoted.
+template<typename K, typename V>
+class LIRSCache final : public Cache<K, V> {
+private:
+    using KeyList = std::list<K, CountingAllocator<K>>;
+    using Iter = typename KeyList::iterator;
+    template<typename T>
+    using Map = std::unordered_map<K, T, std::hash<K>, std::equal_to<K>, CountingAllocator<std::pair<const K, T>>>;
+
+    struct Entry {          // resident block
+        V value;
+        bool lir;
+        bool in_s;
+        Iter s;             // position in S, valid if in_s
+        Iter q;             // position in Q, valid if !lir
+    };
+
+    struct Ghost {          // non-resident HIR block, always in S
+        Iter s;
+        Iter n;             // position in nonresident
+    };
+
+    size_t capacity;
+    size_t lir_capacity;
+    size_t lir_count;
+
+    MemoryCounter entry_bytes; // declared before the containers that report to them
+    MemoryCounter index_bytes;
+    MemoryCounter ghost_bytes;
+
+    Map<Entry> resident;
+    Map<Ghost> ghosts;
+    KeyList s;              // recency stack, front is the top
+    KeyList q;              // resident HIR blocks, back is evicted first
+    KeyList nonresident;    // ghosts in the order they lost residency, front is the oldest
+
+    // Pops HIR blocks off the bottom of S until a LIR block is at the bottom
+    void prune() {
+        while (!s.empty()) {
+            const K& key = s.back();
+            auto it = resident.find(key);
+            if (it != resident.end()) {
+                if (it->second.lir) return;
+                it->second.in_s = false;
+            } else {
+                auto ghost = ghosts.find(key);
+                nonresident.erase(ghost->second.n);
+                ghosts.erase(ghost);
+            }
+            s.pop_back();
+        }
+    }
+
+    // Turns the LIR block at the bottom of S into a resident HIR block at the top of Q
+    void demote_bottom_lir() {
+        Entry& entry = resident.find(s.back())->second;
+        entry.lir = false;
+        entry.in_s = false;
+        q.push_front(s.back());
+        entry.q = q.begin();
+        s.pop_back();
+        lir_count--;
+        prune();
+    }
+
+    void move_to_top(Entry& entry, const K& key) {
+        if (entry.in_s) {
+            s.splice(s.begin(), s, entry.s);
+        } else {
+            s.push_front(key);
+            entry.s = s.begin();
+            entry.in_s = true;
+        }
+    }
+
+    void hit(const K& key, Entry& entry) {
+        if (entry.lir) {
+            bool was_bottom = std::next(entry.s) == s.end();
+            move_to_top(entry, key);
+            if (was_bottom) prune();
+        } else if (entry.in_s && lir_capacity > 0) { // re-referenced within the LIR recency: promote
+            move_to_top(entry, key);
+            q.erase(entry.q);
+            entry.lir = true;
+            lir_count++;
+            if (lir_count > lir_capacity) demote_bottom_lir();
+        } else {
+            move_to_top(entry, key);
+            q.splice(q.begin(), q, entry.q);
+        }
+    }
+
+    // Evicts the resident HIR block at the back of Q; it stays in S as a ghost if it is there.
+    // Q is never empty here because the LIR set is always smaller than the capacity.
+    void evict() {
+        K key = q.back();
+        q.pop_back();
+        auto it = resident.find(key);
+        if (it->second.in_s) {
+            nonresident.push_back(key);
+            ghosts.emplace(key, Ghost{it->second.s, std::prev(nonresident.end())});
+            if (ghosts.size() > capacity) { // bound the non-resident records
+                auto oldest = ghosts.find(nonresident.front());
+                s.erase(oldest->second.s);
+                ghosts.erase(oldest);
+                nonresident.pop_front();
+            }
+        }
+        resident.erase(it);
+    }
+
+public:
+    explicit LIRSCache(size_t size)
+        : capacity(size), lir_capacity(size - std::min(size, std::max<size_t>(1, size / 100))), lir_count(0),
+          resident(CountingAllocator<K>(&entry_bytes)), ghosts(CountingAllocator<K>(&ghost_bytes)),
+          s(CountingAllocator<K>(&index_bytes)), q(CountingAllocator<K>(&index_bytes)),
+          nonresident(CountingAllocator<K>(&ghost_bytes)) {}
+
+    void put(const K& key, const V& value) override {
+        if (capacity == 0) return;
+
+        auto it = resident.find(key);
+        if (it != resident.end()) {
+            it->second.value = value;
+            hit(key, it->second);
+            return;
+        }
+
+        if (resident.size() >= capacity) {
+            evict();
+        }
+
+        auto ghost = ghosts.find(key);
+        if (ghost != ghosts.end()) { // non-resident HIR re-referenced within S: becomes LIR
+            Iter pos = ghost->second.s;
+            nonresident.erase(ghost->second.n);
+            ghosts.erase(ghost);
+            if (lir_capacity == 0) {
+                s.erase(pos); // nothing to promote into; it comes back as a new HIR block
+            } else {
+                Entry& entry = resident.emplace(key, Entry{value, true, true, pos, q.end()}).first->second;
+                s.splice(s.begin(), s, pos);
+                entry.s = s.begin();
+                lir_count++;
+                if (lir_count > lir_capacity) demote_bottom_lir();
+                return;
+            }
+        }
+
+        s.push_front(key);
+        if (lir_count < lir_capacity) { // warm-up: the first blocks fill the LIR set
+            resident.emplace(key, Entry{value, true, true, s.begin(), q.end()});
+            lir_count++;
+        } else {
+            q.push_front(key);
+            resident.emplace(key, Entry{value, false, true, s.begin(), q.begin()});
+        }
+    }
+
+    bool get(const K& key, V& value) override {
+        auto it = resident.find(key);
+        if (it == resident.end()) {
+            return false;
+        }
+        value = it->second.value;
+        hit(key, it->second);
+        return true;
+    }
+
+    size_t size() const override {
+        return resident.size();
+    }
+
+    void clear() override {
+        resident.clear();
+        ghosts.clear();
+        s.clear();
+        q.clear();
+        nonresident.clear();
+        lir_count = 0;
+    }
+
+    MemoryUsage memory_usage() const override {
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.ghosts = ghost_bytes.bytes;
+        usage.index = index_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead + ghost_bytes.overhead + index_bytes.overhead;
+        return usage;
+    }
+};
+
+#endif // LIRS_CACHE_HPP
@@ -5,37 +5,114 @@
 #include <unordered_map>
 #include <list>
 
+// Recency list plus hash index: the layout LRUCache is built on, shared with the segmented
+// policies (2Q, SLRU). The front is the most recently used entry.
 template<typename K, typename V>
-class LRUCache : public Cache<K, V> {
+class LRUList {
 private:
-    size_t capacity;
-    std::list<std::pair<K, V>> cache_list; // double link table
-    std::unordered_map<K, typename std::list<std::pair<K, V>>::iterator> cache_map; //hashing table
+    using Entry = std::pair<K, V>;
+    using List = std::list<Entry, CountingAllocator<Entry>>;
+    using Index = std::unordered_map<K, typename List::iterator, std::hash<K>, std::equal_to<K>,
+                                     CountingAllocator<std::pair<const K, typename List::iterator>>>;
+
+    List cache_list; // double link table
+    Index cache_map; //hashing table
 
 public:
-    explicit LRUCache(size_t size) : capacity(size) {} // constructor
+    using iterator = typename List::iterator;
+
+    LRUList(MemoryCounter* entry_bytes, MemoryCounter* index_bytes)
+        : cache_list(typename List::allocator_type(entry_bytes)),
+          cache_map(typename Index::allocator_type(index_bytes)) {}
 
-    void put(const K& key, const V& value) override { 
+    iterator find(const K& key) {
         auto it = cache_map.find(key);
-        if (it != cache_map.end()) { // if key exists, delete the old one
-            cache_list.erase(it->second);
-            cache_map.erase(it);
+        return it == cache_map.end() ? cache_list.end() : it->second;
+    }
+
+    iterator end() { return cache_list.end(); }
+
+    // Buckets for n keys, so the index does not rehash until it holds more
+    void reserve(size_t n) { cache_map.reserve(n); }
+
+    void touch(iterator it) { // update it to the head
+        cache_list.splice(cache_list.begin(), cache_list, it);
+    }
+
+    void push_front(const K& key, const V& value) { // insert to the head of link table
+        cache_list.push_front({key, value});
+        cache_map[key] = cache_list.begin();
+    }
+
+    // Moves an entry of another list to the head of this one without copying it;
+    // both lists must report to the same counters (splice needs equal allocators)
+    void take(LRUList& other, iterator it) {
+        K key = it->first;
+        other.cache_map.erase(key);
+        cache_list.splice(cache_list.begin(), other.cache_list, it);
+        cache_map[key] = cache_list.begin();
+    }
+
+    Entry& back() { return cache_list.back(); }
+
+    void pop_back() {
+        cache_map.erase(cache_list.back().first);
+        cache_list.pop_back();
+    }
+
+    void erase(iterator it) {
+        cache_map.erase(it->first);
+        cache_list.erase(it);
+    }
+
+    size_t size() const { return cache_list.size(); }
+    bool empty() const { return cache_list.empty(); }
+
+    void clear() {
+        cache_list.clear();
+        cache_map.clear();
+    }
+};
+
+template<typename K, typename V>
+class LRUCache final : public Cache<K, V> {
+private:
+    size_t capacity;
+    IndexMode index_mode;
+    MemoryCounter entry_bytes; // declared before the containers that report to them
+    MemoryCounter index_bytes;
+    LRUList<K, V> cache_list;
+
+public:
+    explicit LRUCache(size_t size, IndexMode mode = IndexMode::Grow)
+        : capacity(size), index_mode(mode), cache_list(&entry_bytes, &index_bytes) { // constructor
+        if (mode == IndexMode::Presized) {
+            cache_list.reserve(capacity);
+        }
+    }
+
+    void put(const K& key, const V& value) override {
+        if (capacity == 0) return;
+        shrink(RESIZE_STEP);
+
+        auto it = cache_list.find(key);
+        if (it != cache_list.end()) { // if key exists, delete the old one
+            cache_list.erase(it);
         }
         else if (cache_list.size() >= capacity) { //cache is full
-            cache_map.erase(cache_list.back().first); // 
             cache_list.pop_back();
         }
-        cache_list.push_front({key, value});
-        cache_map[key] = cache_list.begin(); // insert to the head of link table
+        cache_list.push_front(key, value);
     }
 
     bool get(const K& key, V& value) override {
-        auto it = cache_map.find(key);
-        if (it == cache_map.end()) {
+        shrink(RESIZE_STEP);
+        auto it = cache_list.find(key);
+        if (it == cache_list.end()) {
             return false;
-        } // update it to the head
-        value = it->second->second;
-        cache_list.splice(cache_list.begin(), cache_list, it->second);
+        }
+        value = it->second;
+        cache_list.touch(it);
         return true;
     }
 
@@ -43,9 +120,36 @@ public:
         return cache_list.size();
     }
 
+    // Growing takes effect at once (a Presized index is reserved for the new capacity here).
+    // Shrinking evicts the least recently used surplus RESIZE_STEP entries per later
+    // put()/get(), so size() can exceed the capacity for a while; resize(0) clears at once.
+    void resize(size_t new_capacity) {
+        if (new_capacity == 0) clear();
+        if (new_capacity > capacity && index_mode == IndexMode::Presized) {
+            cache_list.reserve(new_capacity);
+        }
+        capacity = new_capacity;
+    }
+
+    // Evicts up to budget surplus entries now instead of on later calls; returns true while
+    // the cache is still above its capacity
+    bool shrink(size_t budget) {
+        for (; budget > 0 && cache_list.size() > capacity; budget--) {
+            cache_list.pop_back();
+        }
+        return cache_list.size() > capacity;
+    }
+
     void clear() override {
         cache_list.clear();
-        cache_map.clear();
+    }
+
+    MemoryUsage memory_usage() const override {
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.index = index_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead + index_bytes.overhead;
+        return usage;
     }
 };
 
@@ -0,0 +1,124 @@
+#include "memcache_client.hpp"
+#include "memcache_server.hpp"
+#include "workload.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+// Loopback benchmark of the memcached server: an in-process MemcacheServer on an ephemeral
+// TCP port and a Unix socket, driven by client threads doing cache-aside (get, then set on a
+// miss) over Zipf keys, one request at a time and pipelined. Every hit is checked.
+
+std::string value_for(int key, size_t size) {
+    std::string value(size, '\0');
+    for (size_t i = 0; i < size; i++) value[i] = static_cast<char>('a' + (key + i) % 26);
+    return value;
+}
+
+int main(int argc, char** argv) {
+    size_t server_threads = 2;
+    size_t clients = 4;
+    size_t requests = 50000; // per client
+    int data_range = 100000;
+    size_t value_size = 100;
+    size_t memory_mb = 64;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            server_threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            clients = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            requests = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            data_range = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--value-size") == 0 && i + 1 < argc) {
+            value_size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            memory_mb = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    MemcacheServerConfig config;
+    config.port = 0;
+    config.unix_path = "/tmp/arcd_bench." + std::to_string(::getpid()) + ".sock";
+    config.threads = server_threads;
+    config.memory_bytes = memory_mb << 20;
+
+    PatternStream<ZipfianPattern> stream(ZipfianPattern(data_range, 0.99), requests * clients);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Server loops: " << server_threads << ", clients: " << clients << ", requests/client: " << requests
+              << ", keys: " << data_range << ", value size: " << value_size << ", memory: " << memory_mb << " MB\n";
+    std::cout << "Transport\tDepth\tHit Rate (%)\tKops/s\tp50 us\tp99 us\t(per batch)\n";
+    try {
+        MemcacheServer server(config);
+        server.start();
+        for (bool tcp : {true, false}) {
+            for (size_t depth : {1, 16}) {
+                // the store is shared by every run, so later runs start warm
+                std::atomic<uint64_t> hits(0), corrupt(0);
+                std::vector<std::vector<double>> latencies(clients);
+                std::vector<std::thread> threads;
+                auto start = std::chrono::steady_clock::now();
+                for (size_t c = 0; c < clients; c++) {
+                    threads.emplace_back([&, c] {
+                        auto client = tcp ? MemcacheClient::connect_tcp("127.0.0.1", server.port())
+                                          : MemcacheClient::connect_unix(config.unix_path);
+                        auto slice = stream.split(clients, c);
+                        std::vector<int> keys(depth);
+                        std::vector<int> missed;
+                        uint64_t local_hits = 0;
+                        while (true) {
+                            size_t n = slice.next_block(keys.data(), depth);
+                            if (n == 0) break;
+                            auto t0 = std::chrono::steady_clock::now();
+                            for (size_t i = 0; i < n; i++) client->send_get(std::to_string(keys[i]));
+                            client->flush();
+                            missed.clear();
+                            for (size_t i = 0; i < n; i++) {
+                                std::string value;
+                                if (client->read_get(value)) {
+                                    local_hits++;
+                                    if (value != value_for(keys[i], value_size)) corrupt++;
+                                } else {
+                                    missed.push_back(keys[i]);
+                                }
+                            }
+                            for (int key : missed) client->send_set(std::to_string(key), value_for(key, value_size));
+                            client->flush();
+                            for (size_t i = 0; i < missed.size(); i++) client->read_set();
+                            latencies[c].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+                        }
+                        hits += local_hits;
+                    });
+                }
+                for (auto& thread : threads) thread.join();
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                std::vector<double> all;
+                for (const auto& samples : latencies) all.insert(all.end(), samples.begin(), samples.end());
+                std::sort(all.begin(), all.end());
+                size_t total = requests * clients;
+                std::cout << (tcp ? "TCP\t" : "Unix\t") << "\t" << depth << "\t" << 100.0 * hits / total << "%\t\t"
+                          << total / seconds / 1e3 << "\t" << all[all.size() / 2] << "\t"
+                          << all[std::min(all.size() - 1, all.size() * 99 / 100)] << "\n";
+                if (corrupt) std::cerr << corrupt << " hits returned a wrong value\n";
+            }
+        }
+        std::cout << "Items: " << server.items().items() << ", bytes: " << server.items().bytes() << "\n";
+        server.stop();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+#ifndef MEMCACHE_CLIENT_HPP
+#define MEMCACHE_CLIENT_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Blocking memcached text-protocol client for benchmarks and tools. Requests are queued
+// with send_get/send_set/send_delete and go out together on flush(); responses are then
+// read back in the same order with the matching read_* call, so any number of requests can
+// be pipelined. get/set/erase do one round trip each. Errors throw.
+class MemcacheClient {
+private:
+    int fd;
+    std::string out;
+    std::string in;
+    size_t in_pos;
+
+    explicit MemcacheClient(int fd) : fd(fd), in_pos(0) {}
+
+    static std::system_error error(const std::string& what) {
+        return std::system_error(errno, std::generic_category(), what);
+    }
+
+    void fill() {
+        in.erase(0, in_pos); // keep only the unread part
+        in_pos = 0;
+        char buffer[64 * 1024];
+        while (true) {
+            ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) throw error("recv");
+            if (n == 0) throw std::runtime_error("memcache: connection closed by server");
+            in.append(buffer, static_cast<size_t>(n));
+            return;
+        }
+    }
+
+    std::string read_line() {
+        while (true) {
+            size_t end = in.find("\r\n", in_pos);
+            if (end != std::string::npos) {
+                std::string line = in.substr(in_pos, end - in_pos);
+                in_pos = end + 2;
+                return line;
+            }
+            fill();
+        }
+    }
+
+    void read_exact(std::string& value, size_t size) {
+        while (in.size() - in_pos < size + 2) fill();
+        value.assign(in, in_pos, size);
+        in_pos += size + 2;
+    }
+
+public:
+    static std::unique_ptr<MemcacheClient> connect_tcp(const std::string& host, int port) {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw error("socket");
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+            ::close(fd);
+            throw std::invalid_argument("bad IPv4 address: " + host);
+        }
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            std::system_error failure = error("connect to " + host + ":" + std::to_string(port));
+            ::close(fd);
+            throw failure;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return std::unique_ptr<MemcacheClient>(new MemcacheClient(fd));
+    }
+
+    static std::unique_ptr<MemcacheClient> connect_unix(const std::string& path) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) throw std::invalid_argument("unix socket path too long");
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw error("socket");
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            std::system_error failure = error("connect to " + path);
+            ::close(fd);
+            throw failure;
+        }
+        return std::unique_ptr<MemcacheClient>(new MemcacheClient(fd));
+    }
+
+    ~MemcacheClient() {
+        ::close(fd);
+    }
+
+    MemcacheClient(const MemcacheClient&) = delete;
+    MemcacheClient& operator=(const MemcacheClient&) = delete;
+
+    void send_get(const std::string& key) {
+        out += "get ";
+        out += key;
+        out += "\r\n";
+    }
+
+    void send_set(const std::string& key, const std::string& value, uint32_t flags = 0) {
+        out += "set ";
+        out += key;
+        out += ' ';
+        out += std::to_string(flags);
+        out += " 0 ";
+        out += std::to_string(value.size());
+        out += "\r\n";
+        out += value;
+        out += "\r\n";
+    }
+
+    void send_delete(const std::string& key) {
+        out += "delete ";
+        out += key;
+        out += "\r\n";
+    }
+
+    void flush() {
+        size_t done = 0;
+        while (done < out.size()) {
+            ssize_t n = ::send(fd, out.data() + done, out.size() - done, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) throw error("send");
+            done += static_cast<size_t>(n);
+        }
+        out.clear();
+    }
+
+    // Response to a single-key get: true and the value on a hit
+    bool read_get(std::string& value) {
+        std::string line = read_line();
+        if (line == "END") return false;
+        if (line.compare(0, 6, "VALUE ") != 0) throw std::runtime_error("memcache: unexpected reply: " + line);
+        size_t bytes_at = line.rfind(' ');
+        size_t size = std::strtoull(line.c_str() + bytes_at + 1, nullptr, 10);
+        read_exact(value, size);
+        line = read_line();
+        if (line != "END") throw std::runtime_error("memcache: unexpected reply: " + line);
+        return true;
+    }
+
+    void read_set() {
+        std::string line = read_line();
+        if (line != "STORED") throw std::runtime_error("memcache: set failed: " + line);
+    }
+
+    bool read_delete() {
+        std::string line = read_line();
+        if (line == "DELETED") return true;
+        if (line == "NOT_FOUND") return false;
+        throw std::runtime_error("memcache: unexpected reply: " + line);
+    }
+
+    bool get(const std::string& key, std::string& value) {
+        send_get(key);
+        flush();
+        return read_get(value);
+    }
+
+    void set(const std::string& key, const std::string& value) {
+        send_set(key, value);
+        flush();
+        read_set();
+    }
+
+    bool erase(const std::string& key) {
+        send_delete(key);
+        flush();
+        return read_delete();
+    }
+};
+
+#endif // MEMCACHE_CLIENT_HPP
@@ -0,0 +1,535 @@
+#ifndef MEMCACHE_SERVER_HPP
+#define MEMCACHE_SERVER_HPP
+
+#include "arc_cache.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct MemcacheItem {
+    std::string data;
+    uint32_t flags;
+    uint64_t cas;
+};
+
+// The server's storage: ARCache shards, each bounded by its share of a byte budget rather
+// than an entry count. An item weighs its key and data plus a fixed per-entry overhead;
+// after each store the shard calls ARCache::evict_one() until it is back under budget.
+// Items are immutable and shared, so a get() copies a pointer under the shard lock.
+class ItemStore {
+public:
+    static const size_t ITEM_OVERHEAD = 64; // map node, list node and item header, roughly
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        ARCache<std::string, std::shared_ptr<const MemcacheItem>> cache;
+        size_t bytes = 0;
+        size_t budget;
+
+        explicit Shard(size_t budget) : cache(std::max<size_t>(1, budget / ITEM_OVERHEAD)), budget(budget) {
+            cache.set_eviction_callback([this](const std::string& key, const std::shared_ptr<const MemcacheItem>& item) {
+                bytes -= weight(key, *item);
+            });
+        }
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<uint64_t> next_cas;
+
+    static size_t weight(const std::string& key, const MemcacheItem& item) {
+        return key.size() + item.data.size() + ITEM_OVERHEAD;
+    }
+
+    Shard& shard_for(const std::string& key) const {
+        size_t h = std::hash<std::string>()(key) * 0x9e3779b97f4a7c15ULL;
+        return *shards[(h >> 32) % shards.size()];
+    }
+
+public:
+    ItemStore(size_t memory_bytes, size_t num_shards) : next_cas(1) {
+        num_shards = std::max<size_t>(1, num_shards);
+        for (size_t i = 0; i < num_shards; i++) {
+            shards.push_back(std::make_unique<Shard>(memory_bytes / num_shards));
+        }
+    }
+
+    // Largest key + data that fits in a shard
+    size_t max_item_size() const {
+        return shards[0]->budget > ITEM_OVERHEAD ? shards[0]->budget - ITEM_OVERHEAD : 0;
+    }
+
+    std::shared_ptr<const MemcacheItem> get(const std::string& key) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::shared_ptr<const MemcacheItem> item;
+        shard.cache.get(key, item);
+        return item;
+    }
+
+    // Returns false if the item can never fit
+    bool set(const std::string& key, uint32_t flags, std::string data) {
+        if (key.size() + data.size() > max_item_size()) return false;
+        auto item = std::make_shared<const MemcacheItem>(MemcacheItem{std::move(data), flags, next_cas++});
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (auto* old = shard.cache.peek(key)) shard.bytes -= weight(key, **old);
+        shard.cache.put(key, item);
+        shard.bytes += weight(key, *item);
+        while (shard.bytes > shard.budget && shard.cache.evict_one()) {
+        }
+        return true;
+    }
+
+    bool erase(const std::string& key) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto* old = shard.cache.peek(key);
+        if (!old) return false;
+        shard.bytes -= weight(key, **old);
+        shard.cache.erase(key);
+        return true;
+    }
+
+    size_t items() const {
+        size_t total = 0;
+        for (const auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total += shard->cache.size();
+        }
+        return total;
+    }
+
+    size_t bytes() const {
+        size_t total = 0;
+        for (const auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total += shard->bytes;
+        }
+        return total;
+    }
+};
+
+// The memcached text protocol subset: get, gets (one or more keys), set, delete, version
+// and quit. Requests may be pipelined; process() handles every complete request in the
+// buffer and leaves a partial one for later. exptime is accepted but not enforced.
+class MemcacheProtocol {
+public:
+    static const size_t MAX_KEY = 250;
+    static const size_t MAX_LINE = 2048;
+    static const size_t MAX_DATA = 64 << 20; // larger set requests close the connection
+
+private:
+    static bool parse_number(const std::string& token, uint64_t limit, uint64_t& value) {
+        if (token.empty() || token.size() > 20) return false;
+        char* end;
+        errno = 0;
+        unsigned long long parsed = std::strtoull(token.c_str(), &end, 10);
+        if (errno != 0 || *end != '\0' || token[0] == '-' || parsed > limit) return false;
+        value = parsed;
+        return true;
+    }
+
+    static void split(const char* line, size_t size, std::vector<std::string>& tokens) {
+        tokens.clear();
+        size_t i = 0;
+        while (i < size) {
+            while (i < size && line[i] == ' ') i++;
+            size_t start = i;
+            while (i < size && line[i] != ' ') i++;
+            if (i > start) tokens.emplace_back(line + start, i - start);
+        }
+    }
+
+    static void retrieve(ItemStore& store, const std::vector<std::string>& tokens, bool with_cas, std::string& out) {
+        for (size_t i = 1; i < tokens.size(); i++) {
+            if (tokens[i].size() > MAX_KEY) {
+                out += "CLIENT_ERROR bad command line format\r\n";
+                return;
+            }
+        }
+        for (size_t i = 1; i < tokens.size(); i++) {
+            auto item = store.get(tokens[i]);
+            if (!item) continue;
+            out += "VALUE ";
+            out += tokens[i];
+            out += ' ';
+            out += std::to_string(item->flags);
+            out += ' ';
+            out += std::to_string(item->data.size());
+            if (with_cas) {
+                out += ' ';
+                out += std::to_string(item->cas);
+            }
+            out += "\r\n";
+            out += item->data;
+            out += "\r\n";
+        }
+        out += "END\r\n";
+    }
+
+public:
+    // Consumes complete requests from data and appends the responses to out. Returns the
+    // number of bytes consumed; sets close when the connection should be closed.
+    static size_t process(ItemStore& store, const char* data, size_t size, std::string& out, bool& close) {
+        std::vector<std::string> tokens;
+        size_t pos = 0;
+        while (pos < size && !close) {
+            const char* newline = static_cast<const char*>(std::memchr(data + pos, '\n', size - pos));
+            if (!newline) {
+                if (size - pos > MAX_LINE) {
+                    out += "CLIENT_ERROR line too long\r\n";
+                    close = true;
+                }
+                break;
+            }
+            size_t line_end = newline - data;
+            size_t line_size = line_end - pos;
+            if (line_size > 0 && data[line_end - 1] == '\r') line_size--;
+            split(data + pos, line_size, tokens);
+            size_t next = line_end + 1;
+
+            if (tokens.empty()) {
+                out += "ERROR\r\n";
+            } else if ((tokens[0] == "get" || tokens[0] == "gets") && tokens.size() > 1) {
+                retrieve(store, tokens, tokens[0] == "gets", out);
+            } else if (tokens[0] == "set" && (tokens.size() == 5 || tokens.size() == 6)) {
+                uint64_t flags, exptime, bytes;
+                if (!parse_number(tokens[4], MAX_DATA, bytes)) { // cannot tell where the data ends
+                    out += "CLIENT_ERROR bad data chunk\r\n";
+                    close = true;
+                    break;
+                }
+                if (size - next < bytes + 2) break; // wait for the data block
+                const char* block = data + next;
+                next += bytes + 2;
+                bool noreply = tokens.size() == 6 && tokens[5] == "noreply";
+                if (tokens[1].size() > MAX_KEY || !parse_number(tokens[2], UINT32_MAX, flags) ||
+                    !parse_number(tokens[3], UINT32_MAX, exptime) || (tokens.size() == 6 && !noreply)) {
+                    out += "CLIENT_ERROR bad command line format\r\n"; // the data block is skipped
+                } else if (block[bytes] != '\r' || block[bytes + 1] != '\n') {
+                    out += "CLIENT_ERROR bad data chunk\r\n";
+                } else if (!store.set(tokens[1], static_cast<uint32_t>(flags), std::string(block, bytes))) {
+                    out += "SERVER_ERROR object too large for cache\r\n";
+                } else if (!noreply) {
+                    out += "STORED\r\n";
+                }
+            } else if (tokens[0] == "delete" && (tokens.size() == 2 || tokens.size() == 3)) {
+                bool noreply = tokens.size() == 3 && tokens[2] == "noreply";
+                bool deleted = tokens[1].size() <= MAX_KEY && store.erase(tokens[1]);
+                if (!noreply) out += deleted ? "DELETED\r\n" : "NOT_FOUND\r\n";
+            } else if (tokens[0] == "version") {
+                out += "VERSION arcd-1.0\r\n";
+            } else if (tokens[0] == "quit") {
+                close = true;
+            } else {
+                out += "ERROR\r\n";
+            }
+            pos = next;
+        }
+        return pos;
+    }
+};
+
+struct MemcacheServerConfig {
+    std::string host = "127.0.0.1";
+    int port = 11211;           // 0 picks a free port, -1 disables TCP
+    std::string unix_path;      // empty disables the Unix socket
+    size_t threads = 0;         // event loops; 0 means one per core
+    size_t memory_bytes = 64 << 20;
+    size_t shards = 64;
+};
+
+// memcached-compatible server over ItemStore. Every event loop runs its own epoll instance
+// on its own thread. For TCP each loop binds its own listening socket to the same port with
+// SO_REUSEPORT, so the kernel spreads connections across loops; the Unix socket has a single
+// listener registered in every loop with EPOLLEXCLUSIVE, so one loop wakes per connection.
+// A connection stays on the loop that accepted it. Listening sockets are bound in the
+// constructor (errors throw std::system_error); start() runs the loops and stop() ends them.
+class MemcacheServer {
+private:
+    static const size_t READ_CHUNK = 64 * 1024;
+    static const size_t MAX_BACKLOG = 4 << 20; // pending output above which a connection is not read
+
+    struct Connection {
+        int fd;
+        std::string in;
+        std::string out;
+        size_t out_pos = 0;
+        bool closing = false;  // no more requests are read; closed once the output is sent
+        uint32_t events = EPOLLIN | EPOLLRDHUP;
+    };
+
+    struct Loop {
+        int epoll_fd = -1;
+        int wake_fd = -1;
+        int tcp_fd = -1;
+        std::unordered_map<int, std::unique_ptr<Connection>> connections;
+        std::thread thread;
+    };
+
+    MemcacheServerConfig config;
+    ItemStore store;
+    int unix_fd;
+    int bound_port;
+    std::vector<std::unique_ptr<Loop>> loops;
+    std::atomic<bool> stopping;
+    bool started;
+
+    static std::system_error error(const std::string& what) {
+        return std::system_error(errno, std::generic_category(), what);
+    }
+
+    int listen_tcp(int port) {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw error("socket");
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0) {
+            ::close(fd);
+            throw error("SO_REUSEPORT");
+        }
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (::inet_pton(AF_INET, config.host.c_str(), &addr.sin_addr) != 1) {
+            ::close(fd);
+            throw std::invalid_argument("bad IPv4 address: " + config.host);
+        }
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+            std::system_error failure = error("bind/listen on port " + std::to_string(port));
+            ::close(fd);
+            throw failure;
+        }
+        return fd;
+    }
+
+    int listen_unix() {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (config.unix_path.size() >= sizeof(addr.sun_path)) throw std::invalid_argument("unix socket path too long");
+        std::memcpy(addr.sun_path, config.unix_path.c_str(), config.unix_path.size() + 1);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw error("socket");
+        ::unlink(config.unix_path.c_str()); // a stale socket from an earlier run
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+            std::system_error failure = error("bind/listen on " + config.unix_path);
+            ::close(fd);
+            throw failure;
+        }
+        return fd;
+    }
+
+    static void watch(Loop& loop, int fd, uint32_t events, int op = EPOLL_CTL_ADD) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (::epoll_ctl(loop.epoll_fd, op, fd, &event) != 0) throw error("epoll_ctl");
+    }
+
+    void accept_all(Loop& loop, int listener, bool tcp) {
+        while (true) {
+            int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return; // EAGAIN, or another loop took it
+            if (tcp) {
+                int one = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            }
+            auto connection = std::make_unique<Connection>();
+            connection->fd = fd;
+            watch(loop, fd, EPOLLIN | EPOLLRDHUP);
+            loop.connections.emplace(fd, std::move(connection));
+        }
+    }
+
+    void close_connection(Loop& loop, Connection& connection) {
+        ::close(connection.fd); // also removes it from the epoll set
+        loop.connections.erase(connection.fd);
+    }
+
+    // Writes pending output; returns false if the connection failed
+    static bool flush(Connection& connection) {
+        while (connection.out_pos < connection.out.size()) {
+            ssize_t n = ::send(connection.fd, connection.out.data() + connection.out_pos,
+                               connection.out.size() - connection.out_pos, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            connection.out_pos += static_cast<size_t>(n);
+        }
+        connection.out.clear();
+        connection.out_pos = 0;
+        return true;
+    }
+
+    void on_event(Loop& loop, Connection& connection, uint32_t events) {
+        if (events & EPOLLERR) {
+            close_connection(loop, connection);
+            return;
+        }
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+            char buffer[READ_CHUNK];
+            while (connection.out.size() - connection.out_pos < MAX_BACKLOG && !connection.closing) {
+                ssize_t n = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    close_connection(loop, connection);
+                    return;
+                }
+                if (n == 0) { // the peer is done sending; answer what it sent, then close
+                    connection.closing = true;
+                    break;
+                }
+                connection.in.append(buffer, static_cast<size_t>(n));
+                size_t used = MemcacheProtocol::process(store, connection.in.data(), connection.in.size(),
+                                                        connection.out, connection.closing);
+                connection.in.erase(0, used);
+            }
+        }
+        if (!flush(connection) || (connection.closing && connection.out.empty())) {
+            close_connection(loop, connection);
+            return;
+        }
+        // Read only while the output backlog is small, and poll for output only while some is pending
+        bool reading = !connection.closing && connection.out.size() - connection.out_pos < MAX_BACKLOG;
+        uint32_t wanted = (reading ? uint32_t(EPOLLIN | EPOLLRDHUP) : 0u) | (connection.out.empty() ? 0u : uint32_t(EPOLLOUT));
+        if (wanted != connection.events) {
+            watch(loop, connection.fd, wanted, EPOLL_CTL_MOD);
+            connection.events = wanted;
+        }
+    }
+
+    void run(Loop& loop) {
+        epoll_event events[256];
+        while (!stopping.load(std::memory_order_acquire)) {
+            int n = ::epoll_wait(loop.epoll_fd, events, 256, -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            for (int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+                if (fd == loop.wake_fd) {
+                    continue;
+                } else if (fd == loop.tcp_fd) {
+                    accept_all(loop, fd, true);
+                } else if (fd == unix_fd) {
+                    accept_all(loop, fd, false);
+                } else {
+                    auto it = loop.connections.find(fd);
+                    if (it != loop.connections.end()) on_event(loop, *it->second, events[i].events);
+                }
+            }
+        }
+    }
+
+public:
+    explicit MemcacheServer(const MemcacheServerConfig& config)
+        : config(config), store(config.memory_bytes, config.shards), unix_fd(-1), bound_port(-1),
+          stopping(false), started(false) {
+        size_t threads = config.threads ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+        try {
+            for (size_t i = 0; i < threads; i++) {
+                auto loop = std::make_unique<Loop>();
+                loop->epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+                loop->wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (loop->epoll_fd < 0 || loop->wake_fd < 0) throw error("epoll/eventfd");
+                loops.push_back(std::move(loop));
+                watch(*loops.back(), loops.back()->wake_fd, EPOLLIN);
+            }
+            if (config.port >= 0) {
+                bound_port = config.port;
+                for (auto& loop : loops) { // the first bind picks the port when 0 was asked for
+                    loop->tcp_fd = listen_tcp(bound_port);
+                    if (bound_port == 0) {
+                        sockaddr_in addr{};
+                        socklen_t length = sizeof(addr);
+                        ::getsockname(loop->tcp_fd, reinterpret_cast<sockaddr*>(&addr), &length);
+                        bound_port = ntohs(addr.sin_port);
+                    }
+                    watch(*loop, loop->tcp_fd, EPOLLIN);
+                }
+            }
+            if (!config.unix_path.empty()) {
+                unix_fd = listen_unix();
+                for (auto& loop : loops) watch(*loop, unix_fd, EPOLLIN | EPOLLEXCLUSIVE);
+            }
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    ~MemcacheServer() {
+        stop();
+        release();
+    }
+
+    MemcacheServer(const MemcacheServer&) = delete;
+    MemcacheServer& operator=(const MemcacheServer&) = delete;
+
+    void start() {
+        if (started) return;
+        started = true;
+        for (auto& loop : loops) {
+            Loop* target = loop.get();
+            loop->thread = std::thread([this, target] { run(*target); });
+        }
+    }
+
+    void stop() {
+        stopping.store(true, std::memory_order_release);
+        for (auto& loop : loops) {
+            uint64_t one = 1;
+            if (loop->wake_fd >= 0) (void)!::write(loop->wake_fd, &one, sizeof(one));
+        }
+        for (auto& loop : loops) {
+            if (loop->thread.joinable()) loop->thread.join();
+        }
+    }
+
+    // Closes every descriptor; the loops must not be running
+    void release() {
+        for (auto& loop : loops) {
+            for (auto& connection : loop->connections) ::close(connection.first);
+            loop->connections.clear();
+            if (loop->tcp_fd >= 0) ::close(loop->tcp_fd);
+            if (loop->wake_fd >= 0) ::close(loop->wake_fd);
+            if (loop->epoll_fd >= 0) ::close(loop->epoll_fd);
+            loop->tcp_fd = loop->wake_fd = loop->epoll_fd = -1;
+        }
+        if (unix_fd >= 0) {
+            ::close(unix_fd);
+            ::unlink(config.unix_path.c_str());
+            unix_fd = -1;
+        }
+    }
+
+    int port() const { return bound_port; } // the TCP port actually bound, -1 without TCP
+    size_t num_loops() const { return loops.size(); }
+    ItemStore& items() { return store; }
+};
+
+#endif // MEMCACHE_SERVER_HPP
@@ -0,0 +1,106 @@
+#include "arc_cache.hpp"
+#include "lru_cache.hpp"
+#include "lfu_cache.hpp"
+#include "s3fifo_cache.hpp"
+#include "sieve_cache.hpp"
+#include "lirs_cache.hpp"
+#include "two_q_cache.hpp"
+#include "slru_cache.hpp"
+#include "lecar_cache.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Resident set size of this process, from /proc/self/statm
+size_t current_rss() {
+    size_t pages = 0, resident = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (std::fscanf(f, "%zu %zu", &pages, &resident) != 2) resident = 0;
+    std::fclose(f);
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+void release_free_memory() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+int make_key(size_t i, int*) { return static_cast<int>(i); }
+std::string make_key(size_t i, std::string*) { return "key:" + std::to_string(i); }
+
+// Fills a cache of capacity n with 2n distinct keys, every other one touched twice so that
+// ARC's T2 and ghost lists are populated too, and reports the accounted bytes next to the growth in RSS.
+template<typename T>
+void run(const std::string& type_name, size_t n) {
+    std::map<std::string, std::function<std::unique_ptr<Cache<T, T>>(size_t)>> cache_factories = {
+        {"ARC", [](size_t size) { return std::make_unique<ARCache<T, T>>(size); }},
+        {"LRU", [](size_t size) { return std::make_unique<LRUCache<T, T>>(size); }},
+        {"LFU", [](size_t size) { return std::make_unique<LFUCache<T, T>>(size); }},
+        {"S3FIFO", [](size_t size) { return std::make_unique<S3FIFOCache<T, T>>(size); }},
+        {"SIEVE", [](size_t size) { return std::make_unique<SieveCache<T, T>>(size); }},
+        {"LIRS", [](size_t size) { return std::make_unique<LIRSCache<T, T>>(size); }},
+        {"2Q", [](size_t size) { return std::make_unique<TwoQCache<T, T>>(size); }},
+        {"SLRU", [](size_t size) { return std::make_unique<SLRUCache<T, T>>(size); }},
+        {"LeCaR", [](size_t size) { return std::make_unique<LeCaRCache<T, T>>(size); }}
+    };
+
+    for (const auto& cache_pair : cache_factories) {
+        release_free_memory();
+        size_t rss_before = current_rss();
+        std::unique_ptr<Cache<T, T>> cache = cache_pair.second(n);
+        for (size_t i = 0; i < 2 * n; i++) {
+            T key = make_key(i, static_cast<T*>(nullptr));
+            cache->put(key, key);
+            if (i % 2 == 0) cache->put(key, key);
+        }
+        size_t rss = current_rss() - rss_before;
+        MemoryUsage usage = cache->memory_usage();
+        double resident = static_cast<double>(cache->size());
+
+        std::cout << type_name << "\t" << n << "\t" << cache_pair.first << "\t"
+                  << usage.entries / resident << "\t"
+                  << usage.ghosts / resident << "\t"
+                  << usage.index / resident << "\t"
+                  << usage.allocator_overhead / resident << "\t"
+                  << usage.total() / resident << "\t"
+                  << rss / resident << "\t"
+                  << rss / (1024.0 * 1024.0) << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t max_entries = 1000000; // --max <n>: largest capacity, up to 10^8 given enough RAM
+    bool strings = false;         // --strings: std::string keys and values instead of int
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            max_entries = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--strings") == 0) {
+            strings = true;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Bytes per resident key (string payloads beyond the small-string buffer are not accounted)\n";
+    std::cout << "Type\tEntries\tCache\tentries\tghosts\tindex\tmalloc\ttotal\tRSS\tRSS (MiB)\n";
+    for (size_t n = 10000; n <= max_entries; n *= 10) {
+        if (strings) {
+            run<std::string>("string", n);
+        } else {
+            run<int>("int", n);
+        }
+    }
+    return 0;
+}
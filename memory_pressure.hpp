@@ -0,0 +1,253 @@
+#ifndef MEMORY_PRESSURE_HPP
+#define MEMORY_PRESSURE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// One reading of a cgroup v2 memory controller
+struct MemorySample {
+    uint64_t current = 0;      // memory.current, bytes
+    uint64_t limit = 0;        // memory.max, bytes; 0 when it is "max" (no limit)
+    bool has_pressure = false; // memory.pressure was readable (PSI can be disabled)
+    double some_avg10 = 0;     // % of the last 10 s in which some task stalled on memory
+    double full_avg10 = 0;     // % of the last 10 s in which all tasks did
+
+    // Fraction of the limit in use, or 0 without a limit
+    double usage() const { return limit ? static_cast<double>(current) / static_cast<double>(limit) : 0.0; }
+};
+
+enum class PressureAction {
+    Hold,
+    Shrink,
+    Grow
+};
+
+struct MemoryPressureConfig {
+    std::string cgroup_dir = "/sys/fs/cgroup"; // holds memory.current, memory.max, memory.pressure
+    double high_usage = 0.90;     // shrink above this fraction of memory.max
+    double low_usage = 0.75;      // grow only below it
+    double high_pressure = 10.0;  // shrink when PSI some avg10 reaches this
+    double low_pressure = 1.0;    // grow only below it
+    double shrink_factor = 0.75;  // capacity multiplier per shrink
+    double grow_factor = 1.10;    // and per grow
+    unsigned calm_polls = 3;      // consecutive polls below both low marks before a grow
+    unsigned shrink_cooldown = 3; // polls after a shrink before the next one
+    size_t shrink_budget = 16384; // entries each cache above its capacity releases per poll
+    bool background = false;      // poll from a thread of the controller's own
+    std::chrono::milliseconds interval{1000}; // between background polls
+};
+
+// Resizes registered caches from the memory state of a cgroup v2. Above either high mark
+// every cache shrinks by shrink_factor at once; it grows back by grow_factor only after
+// calm_polls polls in a row below both low marks, so a cgroup hovering around a limit does
+// not make the caches oscillate. Capacities stay within each cache's [min, max].
+//
+// A shrink only lowers the capacity; the memory comes back as the cache evicts down to it.
+// So that a cgroup slow to reflect that does not ratchet the caches down to their minimum,
+// no shrink follows another for shrink_cooldown polls, and a cache whose size is still above
+// the capacity from the last one is left alone. Every poll has each cache still above its
+// capacity release up to shrink_budget entries, so an idle cache gives its memory back too.
+//
+// Without config.background nothing happens until the owner calls poll(). With it, a thread
+// polls every interval and a failed read skips that poll; the resize callbacks then run on
+// that thread, so they must take whatever lock guards their cache.
+class MemoryPressureController {
+private:
+    struct Registration {
+        std::function<void(size_t)> resize;
+        std::function<size_t()> size;       // optional: entries held now
+        std::function<bool(size_t)> shrink; // optional: evicts up to n surplus entries, true while over
+        size_t min_capacity;
+        size_t max_capacity;
+        size_t capacity;
+    };
+
+    MemoryPressureConfig config;
+    std::mutex mutex; // guards the registrations and the poll state
+    std::vector<Registration> caches;
+    unsigned calm = 0;
+    unsigned cooldown = 0; // polls left before another shrink
+    MemorySample last;
+
+    std::mutex stop_mutex;
+    std::condition_variable stop_signal;
+    bool stopping = false;
+    std::thread poller;
+
+    static bool read_file(const std::string& path, std::string& contents) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        contents = buffer.str();
+        return true;
+    }
+
+    // "avg10=1.23" out of a PSI line such as "some avg10=1.23 avg60=0.50 avg300=0.10 total=123"
+    static double parse_avg10(const std::string& line) {
+        size_t at = line.find("avg10=");
+        return at == std::string::npos ? 0.0 : std::stod(line.substr(at + 6));
+    }
+
+    // Returns whether any cache changed
+    bool resize_all(double factor) {
+        bool changed = false;
+        for (Registration& cache : caches) {
+            if (factor < 1 && cache.size && cache.size() > cache.capacity) continue; // still shrinking
+            size_t target = static_cast<size_t>(static_cast<double>(cache.capacity) * factor);
+            if (factor > 1 && target == cache.capacity) target++; // small caches must still grow
+            target = std::min(cache.max_capacity, std::max(cache.min_capacity, target));
+            if (target != cache.capacity) {
+                cache.capacity = target;
+                cache.resize(target);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    void release_surplus() {
+        for (Registration& cache : caches) {
+            if (cache.shrink) cache.shrink(config.shrink_budget);
+        }
+    }
+
+    PressureAction decide(const MemorySample& sample) {
+        bool cooling = cooldown > 0;
+        if (cooling) cooldown--;
+        bool high = (sample.limit && sample.usage() > config.high_usage) ||
+                    (sample.has_pressure && sample.some_avg10 >= config.high_pressure);
+        if (high) {
+            calm = 0;
+            if (cooling || !resize_all(config.shrink_factor)) return PressureAction::Hold;
+            cooldown = config.shrink_cooldown;
+            return PressureAction::Shrink;
+        }
+        bool low = (!sample.limit || sample.usage() < config.low_usage) &&
+                   (!sample.has_pressure || sample.some_avg10 < config.low_pressure);
+        if (!low || (!sample.limit && !sample.has_pressure)) { // with neither signal there is nothing to go by
+            calm = 0;
+            return PressureAction::Hold;
+        }
+        if (++calm < config.calm_polls) return PressureAction::Hold;
+        calm = 0;
+        resize_all(config.grow_factor);
+        return PressureAction::Grow;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(stop_mutex);
+        while (!stop_signal.wait_for(lock, config.interval, [this] { return stopping; })) {
+            lock.unlock();
+            try {
+                poll();
+            } catch (const std::exception&) {
+                // the files may be briefly unreadable (e.g. the cgroup is being moved); try next time
+            }
+            lock.lock();
+        }
+    }
+
+public:
+    explicit MemoryPressureController(MemoryPressureConfig config = MemoryPressureConfig()) : config(std::move(config)) {
+        if (this->config.low_usage > this->config.high_usage || this->config.low_pressure > this->config.high_pressure) {
+            throw std::invalid_argument("memory pressure: low marks must not exceed high marks");
+        }
+        if (this->config.background) poller = std::thread([this] { run(); });
+    }
+
+    ~MemoryPressureController() {
+        {
+            std::lock_guard<std::mutex> lock(stop_mutex);
+            stopping = true;
+        }
+        stop_signal.notify_all();
+        if (poller.joinable()) poller.join();
+    }
+
+    MemoryPressureController(const MemoryPressureController&) = delete;
+    MemoryPressureController& operator=(const MemoryPressureController&) = delete;
+
+    // Registers a cache through its resize function. capacity is its current capacity, from
+    // which the controller scales; it calls resize only when the capacity changes. size and
+    // shrink, if given, report the entries held and release surplus ones (see above).
+    void add(std::function<void(size_t)> resize, size_t capacity, size_t min_capacity, size_t max_capacity,
+             std::function<size_t()> size = nullptr, std::function<bool(size_t)> shrink = nullptr) {
+        if (min_capacity > max_capacity) throw std::invalid_argument("memory pressure: min capacity above max");
+        std::lock_guard<std::mutex> lock(mutex);
+        caches.push_back({std::move(resize), std::move(size), std::move(shrink), min_capacity, max_capacity,
+                          std::min(max_capacity, std::max(min_capacity, capacity))});
+    }
+
+    // Registers a cache with resize(), size() and shrink() members (ARCache, LRUCache,
+    // LFUCache) that only the polling thread uses; a cache shared with other threads needs
+    // the callback form
+    template<typename C>
+    auto add(C& cache, size_t capacity, size_t min_capacity, size_t max_capacity)
+        -> decltype(cache.resize(capacity), cache.shrink(capacity), void()) {
+        add([&cache](size_t target) { cache.resize(target); }, capacity, min_capacity, max_capacity,
+            [&cache] { return cache.size(); }, [&cache](size_t budget) { return cache.shrink(budget); });
+    }
+
+    // Reads the cgroup files. Throws if memory.current or memory.max cannot be read;
+    // memory.pressure is optional.
+    MemorySample read() const {
+        MemorySample sample;
+        std::string text;
+        if (!read_file(config.cgroup_dir + "/memory.current", text)) {
+            throw std::runtime_error("memory pressure: cannot read " + config.cgroup_dir + "/memory.current");
+        }
+        sample.current = std::stoull(text);
+        if (!read_file(config.cgroup_dir + "/memory.max", text)) {
+            throw std::runtime_error("memory pressure: cannot read " + config.cgroup_dir + "/memory.max");
+        }
+        sample.limit = text.compare(0, 3, "max") == 0 ? 0 : std::stoull(text);
+        if (read_file(config.cgroup_dir + "/memory.pressure", text)) {
+            std::istringstream lines(text);
+            std::string line;
+            while (std::getline(lines, line)) {
+                if (line.compare(0, 5, "some ") == 0) {
+                    sample.some_avg10 = parse_avg10(line);
+                    sample.has_pressure = true;
+                } else if (line.compare(0, 5, "full ") == 0) {
+                    sample.full_avg10 = parse_avg10(line);
+                }
+            }
+        }
+        return sample;
+    }
+
+    // Takes one reading and resizes the caches if it calls for it
+    PressureAction poll() {
+        MemorySample sample = read();
+        std::lock_guard<std::mutex> lock(mutex);
+        last = sample;
+        PressureAction action = decide(sample);
+        release_surplus();
+        return action;
+    }
+
+    MemorySample last_sample() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return last;
+    }
+
+    // The capacity the controller last set for the i-th registered cache
+    size_t capacity(size_t i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return caches.at(i).capacity;
+    }
+};
+
+#endif // MEMORY_PRESSURE_HPP
@@ -0,0 +1,151 @@
+#include "arc_cache.hpp"
+#include "lru_cache.hpp"
+#include "memory_pressure.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+// Drives MemoryPressureController from a fake cgroup: a temporary directory whose
+// memory.current, memory.max and memory.pressure files are rewritten between polls.
+
+static std::string cgroup_dir;
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    std::cout << (condition ? "ok\t" : "FAIL\t") << what << "\n";
+    if (!condition) failures++;
+}
+
+static void write_file(const std::string& name, const std::string& contents) {
+    std::ofstream(cgroup_dir + "/" + name) << contents;
+}
+
+// current bytes, memory.max ("max" for no limit) and PSI some avg10
+static void set_state(uint64_t current, const std::string& limit, double some_avg10) {
+    write_file("memory.current", std::to_string(current) + "\n");
+    write_file("memory.max", limit + "\n");
+    write_file("memory.pressure", "some avg10=" + std::to_string(some_avg10) +
+                                      " avg60=0.00 avg300=0.00 total=1\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+}
+
+int main() {
+    char dir_template[] = "/tmp/cgroupXXXXXX";
+    if (!mkdtemp(dir_template)) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    cgroup_dir = dir_template;
+    MemoryPressureConfig config;
+    config.cgroup_dir = cgroup_dir;
+
+    // Marks, cooldown and calm polls
+    {
+        MemoryPressureController controller(config);
+        ARCache<int, int> arc(1000);
+        LRUCache<int, int> lru(1000);
+        for (int i = 0; i < 1000; i++) {
+            arc.put(i, i);
+            lru.put(i, i);
+        }
+        controller.add(arc, 1000, 100, 2000);
+        controller.add(lru, 1000, 100, 1000);
+
+        set_state(950, "1000", 0);
+        check(controller.poll() == PressureAction::Shrink, "usage above the high mark shrinks");
+        check(controller.capacity(0) == 750 && controller.capacity(1) == 750, "by shrink_factor");
+        check(arc.size() <= 750 && lru.size() <= 750, "and the caches release the surplus at once");
+        bool held = true;
+        for (unsigned i = 0; i < config.shrink_cooldown; i++) held = held && controller.poll() == PressureAction::Hold;
+        check(held && controller.capacity(0) == 750, "no second shrink during the cooldown");
+        check(controller.poll() == PressureAction::Shrink && controller.capacity(0) == 562, "another one after it");
+
+        set_state(800, "1000", 0);
+        held = true;
+        for (int i = 0; i < 5; i++) held = held && controller.poll() == PressureAction::Hold;
+        check(held, "between the marks nothing changes");
+
+        set_state(100, "1000", 0.5);
+        check(controller.poll() == PressureAction::Hold && controller.poll() == PressureAction::Hold,
+              "below both low marks it waits calm_polls");
+        check(controller.poll() == PressureAction::Grow && controller.capacity(0) == 618, "before growing");
+
+        set_state(100, "max", 20);
+        check(controller.poll() == PressureAction::Shrink, "PSI alone shrinks without a limit");
+
+        set_state(990, "1000", 50);
+        for (int i = 0; i < 100; i++) controller.poll();
+        check(controller.capacity(0) == 100 && controller.capacity(1) == 100, "capacities stop at the minimum");
+        set_state(0, "1000", 0);
+        for (int i = 0; i < 200; i++) controller.poll();
+        check(controller.capacity(0) == 2000 && controller.capacity(1) == 1000, "and at the maximum");
+
+        std::remove((cgroup_dir + "/memory.current").c_str());
+        bool threw = false;
+        try {
+            controller.poll();
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "an unreadable memory.current throws");
+    }
+
+    // A cache that cannot release memory (no size or shrink callback) is shrunk only once its
+    // size has caught up with the last capacity, so an idle one is not ratcheted to its minimum
+    {
+        MemoryPressureController controller(config);
+        ARCache<int, int> arc(100000);
+        for (int i = 0; i < 100000; i++) arc.put(i, i);
+        controller.add([&arc](size_t target) { arc.resize(target); }, 100000, 100, 100000,
+                       [&arc] { return arc.size(); });
+        set_state(950, "1000", 0);
+        for (int i = 0; i < 8; i++) controller.poll();
+        check(controller.capacity(0) == 75000 && arc.size() > 75000, "an idle cache is shrunk once");
+        arc.shrink(SIZE_MAX);
+        for (unsigned i = 0; i <= config.shrink_cooldown; i++) controller.poll();
+        check(controller.capacity(0) == 56250, "and again once it has evicted down to it");
+    }
+
+    // The same idle cache registered with shrink() gives the memory back from the poller
+    {
+        MemoryPressureController controller(config);
+        ARCache<int, int> arc(100000);
+        for (int i = 0; i < 100000; i++) arc.put(i, i);
+        controller.add(arc, 100000, 100, 100000);
+        set_state(950, "1000", 0);
+        controller.poll();
+        for (int i = 0; i < 3; i++) controller.poll();
+        check(controller.capacity(0) == 75000 && arc.size() == 75000, "an idle cache evicts from the poller");
+    }
+
+    // Background polling; resize runs on the controller's thread
+    {
+        MemoryPressureConfig background = config;
+        background.background = true;
+        background.interval = std::chrono::milliseconds(5);
+        set_state(990, "1000", 0);
+        std::mutex mutex;
+        size_t last = 1000;
+        {
+            MemoryPressureController controller(background);
+            controller.add([&](size_t capacity) {
+                std::lock_guard<std::mutex> lock(mutex);
+                last = capacity;
+            }, 1000, 10, 1000);
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        check(last < 1000, "the background thread shrinks");
+    }
+
+    for (const char* name : {"memory.current", "memory.max", "memory.pressure"}) {
+        std::remove((cgroup_dir + "/" + name).c_str());
+    }
+    ::rmdir(cgroup_dir.c_str());
+    std::cout << (failures ? "FAILED: " + std::to_string(failures) + "\n" : "all passed\n");
+    return failures ? 1 : 0;
+}
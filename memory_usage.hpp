@@ -0,0 +1,76 @@
+#ifndef MEMORY_USAGE_HPP
+#define MEMORY_USAGE_HPP
+
+#include <cstddef>
+#include <new>
+
+// Bytes held by a cache, split by what they are used for
+struct MemoryUsage {
+    size_t entries = 0;            // resident keys and values
+    size_t ghosts = 0;             // history of evicted keys (e.g. ARC's B1/B2)
+    size_t index = 0;              // hash tables and ordering links
+    size_t allocator_overhead = 0; // malloc headers and size-class rounding (estimated)
+
+    size_t total() const { return entries + ghosts + index + allocator_overhead; }
+
+    MemoryUsage& operator+=(const MemoryUsage& other) {
+        entries += other.entries;
+        ghosts += other.ghosts;
+        index += other.index;
+        allocator_overhead += other.allocator_overhead;
+        return *this;
+    }
+};
+
+// Running totals for one category of allocations
+struct MemoryCounter {
+    size_t bytes = 0;
+    size_t overhead = 0;
+
+    // Estimate for a 64-bit glibc malloc: an 8-byte chunk header, 16-byte alignment, 32-byte minimum chunk
+    static size_t malloc_overhead(size_t n) {
+        size_t chunk = (n + sizeof(size_t) + 15) & ~size_t(15);
+        return (chunk < 32 ? 32 : chunk) - n;
+    }
+
+    void add(size_t n) {
+        bytes += n;
+        overhead += malloc_overhead(n);
+    }
+
+    void remove(size_t n) {
+        bytes -= n;
+        overhead -= malloc_overhead(n);
+    }
+};
+
+// Allocator that reports every allocation to a MemoryCounter owned by the cache
+template<typename T>
+class CountingAllocator {
+public:
+    using value_type = T;
+
+    MemoryCounter* counter;
+
+    explicit CountingAllocator(MemoryCounter* counter) noexcept : counter(counter) {}
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept : counter(other.counter) {}
+
+    T* allocate(size_t n) {
+        T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+        counter->add(n * sizeof(T));
+        return p;
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        counter->remove(n * sizeof(T));
+        ::operator delete(p);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U>& other) const noexcept { return counter == other.counter; }
+    template<typename U>
+    bool operator!=(const CountingAllocator<U>& other) const noexcept { return counter != other.counter; }
+};
+
+#endif // MEMORY_USAGE_HPP
@@ -0,0 +1,127 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters collected around a measured region. A counter the kernel or
+// hardware refuses to open stays invalid instead of failing the whole sample.
+struct PerfSample {
+    enum Event { CYCLES, INSTRUCTIONS, LLC_MISSES, DTLB_MISSES, BRANCH_MISSES, NUM_EVENTS };
+
+    uint64_t value[NUM_EVENTS] = {};
+    bool valid[NUM_EVENTS] = {};
+
+    static const char* name(int event) {
+        static const char* names[NUM_EVENTS] = {"cycles", "instructions", "LLC-misses", "dTLB-misses", "branch-misses"};
+        return names[event];
+    }
+};
+
+// Thin wrapper over perf_event_open(2) for the calling thread, user space only.
+// On non-Linux systems, or without permission (perf_event_paranoid), nothing is available.
+class PerfCounters {
+private:
+    int fds[PerfSample::NUM_EVENTS];
+
+#ifdef __linux__
+    static int open_event(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    static uint64_t cache_miss(uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+#endif
+
+public:
+    PerfCounters() {
+        for (int& fd : fds) fd = -1;
+#ifdef __linux__
+        fds[PerfSample::CYCLES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[PerfSample::INSTRUCTIONS] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[PerfSample::LLC_MISSES] = open_event(PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL));
+        fds[PerfSample::DTLB_MISSES] = open_event(PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_DTLB));
+        fds[PerfSample::BRANCH_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        for (int fd : fds) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // pause()/resume() leave the counts in place, to exclude work between measured regions
+    void pause() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+#endif
+    }
+
+    void resume() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    PerfSample stop() {
+        PerfSample sample;
+        pause();
+#ifdef __linux__
+        for (int i = 0; i < PerfSample::NUM_EVENTS; i++) {
+            uint64_t data[3]; // value, time enabled, time running
+            if (fds[i] < 0 || read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) continue;
+            // scale up when the PMU was multiplexed between more events than it has counters
+            sample.value[i] = static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]);
+            sample.valid[i] = true;
+        }
+#endif
+        return sample;
+    }
+};
+
+#endif // PERF_COUNTERS_HPP
@@ -0,0 +1,97 @@
+#include "arc_cache.hpp"
+#include "prefetch_cache.hpp"
+#include "workload.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Demand-only ARC versus ARC behind the stride prefetcher, with a loader that stands in for
+// a block device by sleeping for a fixed latency (the thread waits without using a core, as
+// it would on I/O). On a miss the client loads the block itself and puts it, so each demand
+// miss costs one full latency on the client thread.
+
+template<typename Pattern>
+std::vector<int> materialize(Pattern pattern, size_t length) {
+    auto source = make_stream(std::move(pattern), length);
+    return read_all(source);
+}
+
+int main(int argc, char** argv) {
+    int data_range = 100000;
+    int cache_size = 10000;
+    size_t pattern_length = 200000;
+    int latency_us = 50;
+    size_t depth = 16;
+    size_t workers = 8;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            data_range = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            cache_size = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--length") == 0 && i + 1 < argc) {
+            pattern_length = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+            latency_us = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            depth = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+    const std::chrono::microseconds latency(latency_us);
+    auto loader = [latency](const int& key, int& value) {
+        std::this_thread::sleep_for(latency);
+        value = key;
+        return true;
+    };
+
+    std::vector<std::pair<std::string, std::vector<int>>> traces;
+    traces.emplace_back("Random", materialize(RandomPattern(data_range), pattern_length));
+    traces.emplace_back("Sequential", materialize(PeriodicPattern(data_range, data_range), pattern_length));
+    traces.emplace_back("ScanMixed", materialize(ScanMixedPattern(data_range / 2, 500, 1000, 0.99), pattern_length));
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Keys: " << data_range << ", cache size: " << cache_size << ", accesses: " << pattern_length
+              << ", load latency: " << latency_us << "us, depth: " << depth
+              << ", workers: " << workers << "\n";
+    std::cout << "Pattern\t\tCache Type\tHit Rate (%)\tAccuracy (%)\tCoverage (%)\tus/access\n";
+    for (const auto& trace : traces) {
+        for (bool prefetching : {false, true}) {
+            std::unique_ptr<Cache<int, int>> cache;
+            if (prefetching) {
+                cache = std::make_unique<PrefetchingCache<int, int>>(cache_size, loader, depth, workers);
+            } else {
+                cache = std::make_unique<ARCache<int, int>>(cache_size);
+            }
+            uint64_t hits = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int key : trace.second) {
+                int value;
+                if (cache->get(key, value)) {
+                    hits++;
+                } else {
+                    loader(key, value);
+                    cache->put(key, value);
+                }
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << trace.first << "\t" << (prefetching ? "ARC+prefetch" : "ARC\t") << "\t"
+                      << 100.0 * hits / trace.second.size() << "%\t\t";
+            if (prefetching) {
+                PrefetchStats stats = static_cast<PrefetchingCache<int, int>&>(*cache).stats();
+                std::cout << 100.0 * stats.accuracy() << "%\t\t" << 100.0 * stats.coverage() << "%\t\t";
+            } else {
+                std::cout << "-\t\t-\t\t";
+            }
+            std::cout << seconds * 1e6 / trace.second.size() << "\n";
+        }
+    }
+    return 0;
+}
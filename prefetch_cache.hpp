@@ -0,0 +1,206 @@
+#ifndef PREFETCH_CACHE_HPP
+#define PREFETCH_CACHE_HPP
+
+#include "arc_cache.hpp"
+#include "scan_detector.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Counters exposed through PrefetchingCache::stats()
+struct PrefetchStats {
+    uint64_t issued = 0;        // loads queued for the workers
+    uint64_t dropped = 0;       // loads not queued because the queue was full
+    uint64_t completed = 0;     // prefetched keys inserted into the cache
+    uint64_t used = 0;          // prefetched keys later read on demand
+    uint64_t demand_misses = 0; // get() misses
+
+    // Fraction of prefetched keys that were used
+    double accuracy() const {
+        return completed ? static_cast<double>(used) / completed : 0.0;
+    }
+
+    // Fraction of would-be misses that prefetching turned into hits
+    double coverage() const {
+        return used + demand_misses ? static_cast<double>(used) / (used + demand_misses) : 0.0;
+    }
+};
+
+// ARC over a block-addressed key space, with a stride prefetcher in front of it. Lookups go
+// through a ScanDetector; on a stream that has kept a constant stride for run_threshold
+// accesses, the next `depth` keys along the stride are queued for worker threads, which read
+// them through the loader and insert them with ARCache::prefetch: into T1, never straight
+// into T2. A prefetched key that is read before it is evicted counts as a first reference.
+// Several workers keep loads outstanding in parallel, as a device queue would. The loader
+// returns false for keys that do not exist; it runs without the cache lock held, possibly
+// concurrently with itself. A put(), erase() or clear() cancels the loads of the keys it
+// touches, so a load that read the old value never lands after the newer write. All
+// methods are thread-safe.
+template<typename K, typename V>
+class PrefetchingCache final : public Cache<K, V> {
+    static_assert(std::is_integral<K>::value, "prefetching needs integer (block address) keys");
+
+public:
+    using Loader = std::function<bool(const K&, V&)>;
+
+private:
+    ARCache<K, V> cache;
+    Loader loader;
+    size_t capacity;
+    size_t depth;
+    size_t max_queue;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    ScanDetector<K> detector;
+    std::deque<std::pair<K, uint64_t>> queue;  // (key, ticket)
+    std::unordered_map<K, uint64_t> in_flight; // queued or being loaded, by ticket
+    std::unordered_set<K> prefetched; // inserted by a worker and not read yet; may hold evicted keys
+    PrefetchStats counters;
+    uint64_t next_ticket; // never reused, so a cancelled load cannot match a later one
+    bool stopping;
+    std::vector<std::thread> workers;
+
+    void issue(K key, int64_t stride) { // with the lock held
+        for (size_t i = 0; i < depth; i++) {
+            key = static_cast<K>(key + stride);
+            if (cache.contains(key) || in_flight.count(key)) continue;
+            if (queue.size() >= max_queue) {
+                counters.dropped++;
+                return;
+            }
+            queue.emplace_back(key, next_ticket);
+            in_flight.emplace(key, next_ticket++);
+            counters.issued++;
+        }
+        wake.notify_all();
+    }
+
+    void forget_evicted() { // with the lock held; amortized O(1) per prefetch
+        if (prefetched.size() <= 2 * capacity + 16) return;
+        for (auto it = prefetched.begin(); it != prefetched.end();) {
+            it = cache.contains(*it) ? std::next(it) : prefetched.erase(it);
+        }
+    }
+
+    bool holds(const K& key, uint64_t ticket) const { // with the lock held
+        auto it = in_flight.find(key);
+        return it != in_flight.end() && it->second == ticket;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            K key = queue.front().first;
+            uint64_t ticket = queue.front().second;
+            queue.pop_front();
+            if (!holds(key, ticket)) continue; // cancelled before it started
+
+            lock.unlock();
+            V value;
+            bool found = loader(key, value);
+            lock.lock();
+
+            if (!holds(key, ticket)) continue; // cancelled while loading: the value may be stale
+            in_flight.erase(key);
+            if (found && cache.prefetch(key, value)) {
+                prefetched.insert(key);
+                counters.completed++;
+                forget_evicted();
+            }
+        }
+    }
+
+public:
+    // depth: keys loaded ahead of a detected stream; num_workers: loads in flight at once;
+    // run_threshold: accesses at a constant stride before a stream is prefetched;
+    // max_queue: bound on loads waiting for a worker
+    PrefetchingCache(size_t size, Loader loader, size_t depth = 8, size_t num_workers = 4,
+                     size_t run_threshold = 4, size_t max_queue = 1024)
+        : cache(size), loader(std::move(loader)), capacity(size), depth(depth), max_queue(max_queue),
+          detector(run_threshold), next_ticket(0), stopping(false) {
+        for (size_t i = 0; i < std::max<size_t>(1, num_workers); i++) {
+            workers.emplace_back(&PrefetchingCache::run, this);
+        }
+    }
+
+    ~PrefetchingCache() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    void put(const K& key, const V& value) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        in_flight.erase(key);
+        prefetched.erase(key); // a demand write makes the entry a regular one
+        cache.put(key, value);
+    }
+
+    // Removes key and cancels its load if one is outstanding; returns whether it was cached
+    bool erase(const K& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        in_flight.erase(key);
+        prefetched.erase(key);
+        return cache.erase(key);
+    }
+
+    bool get(const K& key, V& value) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        int64_t stride;
+        bool streaming = detector.observe(key, &stride);
+
+        bool hit;
+        if (prefetched.erase(key)) {
+            hit = cache.get_first_use(key, value);
+            if (hit) counters.used++;
+        } else {
+            hit = cache.get(key, value);
+        }
+        if (!hit) counters.demand_misses++;
+
+        if (streaming) issue(key, stride);
+        return hit;
+    }
+
+    size_t size() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cache.size();
+    }
+
+    void clear() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        cache.clear();
+        detector.clear();
+        queue.clear();
+        in_flight.clear();
+        prefetched.clear();
+        counters = PrefetchStats();
+    }
+
+    PrefetchStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return counters;
+    }
+
+    MemoryUsage memory_usage() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cache.memory_usage();
+    }
+};
+
+#endif // PREFETCH_CACHE_HPP
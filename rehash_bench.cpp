@@ -0,0 +1,70 @@
+#include "arc_cache.hpp"
+#include "lru_cache.hpp"
+#include "latency_histogram.hpp"
+#include "workload.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Tail latency of single operations while a large cache fills from empty, with the index
+// left to grow (every std::unordered_map rehash lands inside one put) versus presized from
+// the capacity. Each access (a get, plus a put on a miss) is timed on its own.
+
+int main(int argc, char** argv) {
+    size_t capacity = 1000000;
+    size_t pattern_length = 0; // 0: three times the capacity
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            capacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--length") == 0 && i + 1 < argc) {
+            pattern_length = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+    if (pattern_length == 0) pattern_length = 3 * capacity;
+
+    // Mostly cold keys, so the cache and its ghost lists fill up during the run
+    auto source = make_stream(ZipfianPattern(static_cast<int>(10 * capacity), 0.8), pattern_length);
+    std::vector<int> trace = read_all(source);
+
+    using Factory = std::function<std::unique_ptr<Cache<int, int>>()>;
+    std::vector<std::pair<std::string, Factory>> variants = {
+        {"LRU grow", [&] { return std::make_unique<LRUCache<int, int>>(capacity); }},
+        {"LRU presized", [&] { return std::make_unique<LRUCache<int, int>>(capacity, IndexMode::Presized); }},
+        {"ARC grow", [&] { return std::make_unique<ARCache<int, int>>(capacity); }},
+        {"ARC presized", [&] { return std::make_unique<ARCache<int, int>>(capacity, IndexMode::Presized); }}
+    };
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Capacity " << capacity << ", " << trace.size() << " accesses, Zipf(0.8) over " << 10 * capacity
+              << " keys\n";
+    std::cout << "Cache\t\tBuild ms\tp50 us\tp99 us\tp99.9 us\tp99.99 us\tmax us\t>1ms\tMemory MB\n";
+    for (const auto& variant : variants) {
+        auto t0 = std::chrono::steady_clock::now();
+        auto cache = variant.second();
+        double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        LatencyHistogram latency;
+        uint64_t stalls = 0;
+        for (int key : trace) {
+            auto start = std::chrono::steady_clock::now();
+            int value;
+            if (!cache->get(key, value)) cache->put(key, key);
+            uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            latency.record(ns);
+            if (ns > 1000000) stalls++;
+        }
+        MemoryUsage usage = cache->memory_usage();
+        std::cout << variant.first << "\t" << build_ms << "\t\t" << latency.value_at(50) / 1e3 << "\t"
+                  << latency.value_at(99) / 1e3 << "\t" << latency.value_at(99.9) / 1e3 << "\t\t"
+                  << latency.value_at(99.99) / 1e3 << "\t\t" << latency.max() / 1e3 << "\t" << stalls << "\t"
+                  << (usage.index + usage.entries + usage.ghosts) / 1e6 << "\n";
+    }
+    return 0;
+}
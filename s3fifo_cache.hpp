@@ -0,0 +1,162 @@
+#ifndef S3FIFO_CACHE_HPP
+#define S3FIFO_CACHE_HPP
+
+#include "cache.hpp"
+#include <unordered_map>
+#include <deque>
+#include <cstdint>
+#include <algorithm>
+
+// S3-FIFO (Yang et al., SOSP 2023): a small FIFO S filters one-hit wonders, a main FIFO M
+// holds the rest, and a ghost FIFO G remembers keys recently dropped from S. A hit only
+// bumps a 2-bit frequency counter; the queues are reordered on eviction, never on a hit.
+template<typename K, typename V>
+class S3FIFOCache final : public Cache<K, V> {
+private:
+    struct Entry {
+        V value;
+        uint8_t freq; // saturates at 3
+    };
+
+    using Fifo = std::deque<K, CountingAllocator<K>>;
+    using GhostFifo = std::deque<std::pair<K, uint64_t>, CountingAllocator<std::pair<K, uint64_t>>>;
+    template<typename T>
+    using Map = std::unordered_map<K, T, std::hash<K>, std::equal_to<K>, CountingAllocator<std::pair<const K, T>>>;
+
+    size_t capacity;
+    size_t small_capacity; // 10% of the capacity
+    size_t main_capacity;
+    uint64_t ghost_seq;    // insertion number of the newest ghost, to skip stale ghost slots
+
+    MemoryCounter entry_bytes; // declared before the containers that report to them
+    MemoryCounter index_bytes;
+    MemoryCounter ghost_bytes;
+
+    Map<Entry> entries;
+    Fifo small; // front is the oldest
+    Fifo main;
+    GhostFifo ghost;
+    Map<uint64_t> ghost_map; // key -> insertion number of its live slot in ghost
+
+    void insert_ghost(const K& key) {
+        ghost.emplace_back(key, ++ghost_seq);
+        ghost_map[key] = ghost_seq;
+        while (ghost.size() > main_capacity) {
+            auto it = ghost_map.find(ghost.front().first);
+            if (it != ghost_map.end() && it->second == ghost.front().second) {
+                ghost_map.erase(it);
+            }
+            ghost.pop_front();
+        }
+    }
+
+    void evict_main() {
+        while (!main.empty()) {
+            K key = main.front();
+            main.pop_front();
+            auto it = entries.find(key);
+            if (it->second.freq > 0) { // reinsert with one less credit
+                it->second.freq--;
+                main.push_back(key);
+            } else {
+                entries.erase(it);
+                return;
+            }
+        }
+    }
+
+    void evict_small() {
+        while (!small.empty()) {
+            K key = small.front();
+            small.pop_front();
+            auto it = entries.find(key);
+            if (it->second.freq > 1) { // accessed again while in S: promote to M
+                it->second.freq = 0;
+                main.push_back(key);
+                if (main.size() > main_capacity) {
+                    evict_main();
+                    return;
+                }
+            } else {
+                entries.erase(it);
+                insert_ghost(key);
+                return;
+            }
+        }
+    }
+
+    void evict() {
+        if (small.size() >= small_capacity || main.empty()) {
+            evict_small();
+        } else {
+            evict_main();
+        }
+    }
+
+public:
+    explicit S3FIFOCache(size_t size)
+        : capacity(size), small_capacity(std::max<size_t>(1, size / 10)),
+          main_capacity(size > small_capacity ? size - small_capacity : 1), ghost_seq(0),
+          entries(CountingAllocator<K>(&entry_bytes)), small(CountingAllocator<K>(&index_bytes)),
+          main(CountingAllocator<K>(&index_bytes)), ghost(CountingAllocator<K>(&ghost_bytes)),
+          ghost_map(CountingAllocator<K>(&ghost_bytes)) {}
+
+    void put(const K& key, const V& value) override {
+        if (capacity == 0) return;
+
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            it->second.value = value;
+            if (it->second.freq < 3) it->second.freq++;
+            return;
+        }
+
+        while (entries.size() >= capacity) {
+            evict();
+        }
+
+        auto ghost_it = ghost_map.find(key);
+        if (ghost_it != ghost_map.end()) { // seen recently: straight into M
+            ghost_map.erase(ghost_it);
+            entries.emplace(key, Entry{value, 0});
+            main.push_back(key);
+        } else {
+            entries.emplace(key, Entry{value, 0});
+            small.push_back(key);
+        }
+    }
+
+    bool get(const K& key, V& value) override {
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            return false;
+        }
+        value = it->second.value;
+        if (it->second.freq < 3) it->second.freq++;
+        return true;
+    }
+
+    size_t size() const override {
+        return entries.size();
+    }
+
+    void clear() override {
+        entries.clear();
+        small.clear();
+        main.clear();
+        ghost.clear();
+        ghost_map.clear();
+        ghost_seq = 0;
+    }
+
+    MemoryUsage memory_usage() const override {
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.ghosts = ghost_bytes.bytes;
+        usage.index = index_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead + ghost_bytes.overhead + index_bytes.overhead;
+        return usage;
+    }
+};
+
+#endif // S3FIFO_CACHE_HPP
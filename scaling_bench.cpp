@@ -0,0 +1,114 @@
+#include "arc_cache.hpp"
+#include "lru_cache.hpp"
+#include "sieve_cache.hpp"
+#include "concurrent_cache.hpp"
+#include "workload.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Multi-threaded throughput of the thread-safe cache variants. Each thread replays its own
+// slice of one Zipf stream (pre-generated, so only cache operations are timed). With
+// --writes, that percentage of the accesses are unconditional puts instead of get-or-put.
+
+double run(Cache<int, int>& cache, const std::vector<std::vector<int>>& slices, unsigned writes, double& hit_rate) {
+    std::atomic<uint64_t> hits(0);
+    std::atomic<size_t> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (const auto& slice : slices) {
+        threads.emplace_back([&, &slice = slice] {
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            uint64_t local_hits = 0;
+            for (size_t i = 0; i < slice.size(); i++) {
+                int key = slice[i];
+                int value;
+                if ((i * 0x9e3779b97f4a7c15ULL >> 32) % 100 < writes) {
+                    cache.put(key, key);
+                } else if (cache.get(key, value)) {
+                    local_hits++;
+                } else {
+                    cache.put(key, key);
+                }
+            }
+            hits += local_hits;
+        });
+    }
+    while (ready.load() < slices.size()) std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t total = 0;
+    for (const auto& slice : slices) total += slice.size();
+    hit_rate = static_cast<double>(hits.load()) / total;
+    return total / seconds / 1e6;
+}
+
+int main(int argc, char** argv) {
+    int data_range = 1000000;
+    int cache_size = 100000;
+    size_t pattern_length = 4000000;
+    size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+    unsigned writes = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            cache_size = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--length") == 0 && i + 1 < argc) {
+            pattern_length = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--writes") == 0 && i + 1 < argc) {
+            writes = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+    const size_t SHARDS = 16;
+
+    auto lru = [](size_t size) -> std::unique_ptr<Cache<int, int>> { return std::make_unique<LRUCache<int, int>>(size); };
+    auto arc = [](size_t size) -> std::unique_ptr<Cache<int, int>> { return std::make_unique<ARCache<int, int>>(size); };
+    auto sieve = [](size_t size) -> std::unique_ptr<Cache<int, int>> { return std::make_unique<SieveCache<int, int>>(size); };
+    std::vector<std::pair<std::string, std::function<std::unique_ptr<Cache<int, int>>()>>> variants = {
+        {"LRU (mutex)", [&] { return std::make_unique<LockedCache<int, int>>(lru(cache_size)); }},
+        {"LRU (sharded)", [&] { return std::make_unique<ShardedCache<int, int>>(cache_size, SHARDS, lru); }},
+        {"ARC (mutex)", [&] { return std::make_unique<LockedCache<int, int>>(arc(cache_size)); }},
+        {"ARC (sharded)", [&] { return std::make_unique<ShardedCache<int, int>>(cache_size, SHARDS, arc); }},
+        {"ARC (combining)", [&] { return std::make_unique<CombiningCache<int, int>>(arc(cache_size)); }},
+        {"SIEVE (mutex)", [&] { return std::make_unique<LockedCache<int, int>>(sieve(cache_size)); }},
+        {"SIEVE (striped)", [&] { return std::make_unique<ConcurrentSieveCache<int, int>>(cache_size); }},
+        {"SIEVE (sharded)", [&] { return std::make_unique<ShardedCache<int, int>>(cache_size, SHARDS, sieve); }}
+    };
+
+    auto stream = make_stream(ZipfianPattern(data_range, 0.99), pattern_length);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Zipf(0.99) over " << data_range << " keys, cache size " << cache_size << ", " << writes
+              << "% writes\n";
+    std::cout << "Threads\tCache\t\t\tHit Rate (%)\tMops/s\n";
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        std::vector<std::vector<int>> slices;
+        for (size_t t = 0; t < threads; t++) {
+            auto part = stream.split(threads, t);
+            std::vector<int> keys(part.remaining());
+            part.next_block(keys.data(), keys.size());
+            slices.push_back(std::move(keys));
+        }
+        for (const auto& variant : variants) {
+            auto cache = variant.second();
+            double hit_rate = 0.0;
+            double mops = run(*cache, slices, writes, hit_rate);
+            std::cout << threads << "\t" << std::left << std::setw(16) << variant.first << std::right << "\t"
+                      << hit_rate * 100 << "%\t\t" << mops << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+#ifndef SCAN_DETECTOR_HPP
+#define SCAN_DETECTOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Recognizes sequential scans in a stream of integer keys. A few stream slots each follow
+// one run of keys advancing by a constant stride (e.g. +1 for a forward range scan, -1
+// backwards); once a run is long enough, further keys on it are reported as scan accesses.
+// Several interleaved scans are tracked at once; the least recently matched slot is reused.
+// Seeing the same key again right away (a lookup followed by the insert of its miss) counts
+// once. Keys that are not integers are never reported as scans.
+template<typename K>
+class ScanDetector {
+private:
+    struct Stream {
+        int64_t last = 0;
+        int64_t stride = 0; // 0 until the second key of the run is seen
+        size_t run = 0;     // keys seen on this stream, 0 when the slot is unused
+        uint64_t used = 0;  // tick of the last match, for slot replacement
+    };
+
+    static const size_t NUM_STREAMS = 8;
+    static const int64_t MAX_STRIDE = 16;
+
+    std::array<Stream, NUM_STREAMS> streams;
+    size_t run_threshold;
+    uint64_t tick;
+
+    bool matched(const Stream& s, int64_t* stride) const {
+        if (s.run < run_threshold || s.stride == 0) return false;
+        if (stride) *stride = s.stride;
+        return true;
+    }
+
+public:
+    explicit ScanDetector(size_t run_threshold = 32) : run_threshold(run_threshold), tick(0) {}
+
+    // Feeds one access; returns true if it continues a run of at least run_threshold keys,
+    // and then stores the run's stride in *stride when given
+    bool observe(const K& key, int64_t* stride = nullptr) {
+        if constexpr (std::is_integral<K>::value) {
+            int64_t k = static_cast<int64_t>(key);
+            tick++;
+            Stream* victim = &streams[0];
+            for (Stream& s : streams) {
+                if (s.run > 0) {
+                    int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(k) - static_cast<uint64_t>(s.last)); // wraps, no overflow
+                    if (delta == 0) {
+                        s.used = tick;
+                        return matched(s, stride);
+                    }
+                    if (s.stride != 0 ? delta == s.stride : (delta >= -MAX_STRIDE && delta <= MAX_STRIDE)) {
+                        s.stride = delta;
+                        s.last = k;
+                        s.run++;
+                        s.used = tick;
+                        return matched(s, stride);
+                    }
+                }
+                if (s.used < victim->used) victim = &s;
+            }
+            *victim = Stream{k, 0, 1, tick}; // start following a new candidate run
+            return false;
+        } else {
+            (void)key;
+            (void)stride;
+            return false;
+        }
+    }
+
+    void clear() {
+        streams = {};
+        tick = 0;
+    }
+};
+
+#endif // SCAN_DETECTOR_HPP
@@ -0,0 +1,41 @@
+#ifndef SERIALIZER_HPP
+#define SERIALIZER_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// Byte encoding of keys and values for tiers that store them outside the process heap.
+// write() appends the encoding of a value to out; read() decodes exactly `size` bytes.
+// Trivially copyable types and std::string are provided; specialize for other types.
+template<typename T, typename = void>
+struct Serializer;
+
+template<typename T>
+struct Serializer<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+    static void write(const T& value, std::string& out) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static T read(const char* data, size_t size) {
+        if (size != sizeof(T)) throw std::runtime_error("serializer: size mismatch");
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+};
+
+template<>
+struct Serializer<std::string> {
+    static void write(const std::string& value, std::string& out) {
+        out.append(value);
+    }
+
+    static std::string read(const char* data, size_t size) {
+        return std::string(data, size);
+    }
+};
+
+#endif // SERIALIZER_HPP
@@ -0,0 +1,736 @@
+#ifndef SHM_ARC_CACHE_HPP
+#define SHM_ARC_CACHE_HPP
+
+#include "cache.hpp"
+#include "serializer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Counters exposed through ShmARCSegment::stats(), shared by every attached process
+struct SharedARCStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t rejected = 0;   // puts dropped because no slab chunk could be found for them
+    uint64_t reassigned = 0; // slab pages moved from one size class to another
+    uint64_t recoveries = 0; // resets after a process died holding the lock
+};
+
+// ARC over byte-string keys and values, kept entirely in a POSIX shared-memory segment so
+// that every process on a host that opens the same name shares one cache. Nothing in the
+// segment is a pointer: list links and index chains are entry numbers and item bytes are
+// found by offset, so each process may map it at a different address.
+//
+// Layout: a header with the ARC state, an array of 2 * capacity entries (the most ARC's
+// directory holds), a chained hash index of entry numbers, a record per slab page, and the
+// slab pages. Pages are handed out on demand to size classes 1.25x apart, like memcached's,
+// and cut into chunks holding one item's owner, key and value. When a class has no free
+// chunk, the least recently used resident of that class near ARC's eviction end is demoted
+// to a ghost. If there is none, a page is moved over as memcached's slab rebalancer does:
+// the emptiest page of the class ARC would evict from next, after its residents are demoted.
+// With fewer pages than size classes in use, pages keep moving, so the memory should still
+// be several pages per class.
+// Ghost entries in B1/B2 keep only the 64-bit key hash, so they cost no slab memory.
+//
+// All operations take a robust process-shared mutex. If a process dies holding it, the
+// next locker cannot trust the half-updated lists, so it empties the cache and carries on:
+// a crash costs the cached data, never the segment. The first process creates and formats
+// the segment; later ones wait for it to be formatted and must ask for the same layout.
+// The segment outlives its processes until remove() unlinks it.
+class ShmARCSegment {
+public:
+    static constexpr size_t PAGE_BYTES = 1 << 20; // slab page, also the largest chunk
+    static constexpr size_t CHUNK_HEADER = sizeof(uint64_t); // owner of a used chunk, free-list link of a free one
+
+private:
+    static constexpr uint64_t MAGIC = 0x3230524341484d53ULL; // "SMHARC02"
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr uint64_t NO_CHUNK = UINT64_MAX;
+    static constexpr size_t MAX_CLASSES = 64;
+    static constexpr size_t MAX_SEARCH = 64;   // residents checked for one of the wanted class before a page moves
+    static constexpr uint64_t OWNED = uint64_t(1) << 62; // first word of a used chunk: OWNED | entry
+
+    enum ListId : uint8_t { T1, T2, B1, B2, FREE };
+
+    struct List {
+        uint32_t head; // MRU end
+        uint32_t tail; // LRU end
+        uint64_t size;
+    };
+
+    struct Entry {
+        uint64_t hash;
+        uint64_t chunk;      // offset of the key and value bytes; NO_CHUNK in B1/B2
+        uint32_t prev, next; // toward the head / tail of the entry's list
+        uint32_t chain;      // next entry in the same index bucket
+        uint32_t key_size;
+        uint32_t value_size;
+        uint8_t list;
+        uint8_t slab_class;
+    };
+
+    struct Page {
+        uint32_t used;       // chunks holding an item
+        uint32_t slab_class;
+    };
+
+    struct Header {
+        uint64_t magic; // written last by the creator
+        uint64_t segment_bytes;
+        uint64_t capacity;
+        uint64_t num_buckets;
+        uint64_t num_pages;
+        uint64_t num_classes;
+        uint64_t entries_at;
+        uint64_t buckets_at;
+        uint64_t page_table_at;
+        uint64_t pages_at;
+        uint32_t class_size[MAX_CLASSES];
+        pthread_mutex_t lock;
+        SharedARCStats stats;
+        // Replacement state, rebuilt from scratch by reset()
+        uint64_t p;
+        List lists[4];
+        uint32_t free_entries; // chained through Entry::next
+        uint64_t pages_used;
+        uint64_t class_free[MAX_CLASSES]; // first free chunk per class, doubly chained through the chunks
+        uint64_t class_pages[MAX_CLASSES];
+    };
+
+    struct Layout {
+        uint64_t capacity, num_buckets, num_pages;
+        uint64_t entries_at, buckets_at, page_table_at, pages_at, bytes;
+    };
+
+    std::string name;
+    char* base;
+    size_t bytes;
+    Header* header;
+    Entry* entries;
+    uint32_t* buckets;
+    Page* pages;
+
+    static std::system_error error(const std::string& what) {
+        return std::system_error(errno, std::generic_category(), what);
+    }
+
+    static uint64_t align(uint64_t n, uint64_t to) {
+        return (n + to - 1) / to * to;
+    }
+
+    static Layout layout_for(size_t capacity, size_t memory_bytes) {
+        if (capacity == 0 || capacity >= NIL / 2) throw std::invalid_argument("shm cache: bad capacity");
+        if (memory_bytes < PAGE_BYTES) throw std::invalid_argument("shm cache: memory must hold at least one slab page");
+        Layout layout;
+        layout.capacity = capacity;
+        layout.num_buckets = 1;
+        while (layout.num_buckets < 2 * capacity) layout.num_buckets *= 2;
+        layout.num_pages = memory_bytes / PAGE_BYTES;
+        layout.entries_at = align(sizeof(Header), 64);
+        layout.buckets_at = align(layout.entries_at + 2 * capacity * sizeof(Entry), 64);
+        layout.page_table_at = align(layout.buckets_at + layout.num_buckets * sizeof(uint32_t), 64);
+        layout.pages_at = align(layout.page_table_at + layout.num_pages * sizeof(Page), 4096);
+        layout.bytes = layout.pages_at + layout.num_pages * PAGE_BYTES;
+        return layout;
+    }
+
+    static uint64_t hash_of(const char* data, size_t size) {
+        uint64_t h = 0xcbf29ce484222325ULL; // FNV-1a, then a splitmix64 finalizer for the low bits
+        for (size_t i = 0; i < size; i++) h = (h ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    void format(const Layout& layout) {
+        header->segment_bytes = layout.bytes;
+        header->capacity = layout.capacity;
+        header->num_buckets = layout.num_buckets;
+        header->num_pages = layout.num_pages;
+        header->entries_at = layout.entries_at;
+        header->buckets_at = layout.buckets_at;
+        header->page_table_at = layout.page_table_at;
+        header->pages_at = layout.pages_at;
+        size_t classes = 0;
+        for (uint64_t size = 64; size < PAGE_BYTES && classes < MAX_CLASSES - 1; size = align(size * 5 / 4, 8)) {
+            header->class_size[classes++] = static_cast<uint32_t>(size);
+        }
+        header->class_size[classes++] = PAGE_BYTES;
+        header->num_classes = classes;
+
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+        int rc = pthread_mutex_init(&header->lock, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+        if (rc != 0) throw std::system_error(rc, std::generic_category(), "shm cache: mutex init");
+        header->stats = SharedARCStats();
+        reset();
+    }
+
+    // Empties the cache: every entry free, every slab page unassigned
+    void reset() {
+        header->p = 0;
+        for (List& list : header->lists) list = List{NIL, NIL, 0};
+        size_t num_entries = 2 * header->capacity;
+        for (size_t i = 0; i < num_entries; i++) {
+            entries[i].list = FREE;
+            entries[i].next = i + 1 < num_entries ? static_cast<uint32_t>(i + 1) : NIL;
+        }
+        header->free_entries = 0;
+        std::fill(buckets, buckets + header->num_buckets, NIL);
+        header->pages_used = 0;
+        std::fill(header->class_free, header->class_free + MAX_CLASSES, NO_CHUNK);
+        std::fill(header->class_pages, header->class_pages + MAX_CLASSES, 0);
+    }
+
+    void lock() {
+        int rc = pthread_mutex_lock(&header->lock);
+        if (rc == EOWNERDEAD) {
+            // The owner died mid-update, so the lists may be inconsistent: start over empty
+            reset();
+            header->stats.recoveries++;
+            pthread_mutex_consistent(&header->lock);
+        } else if (rc != 0) {
+            throw std::system_error(rc, std::generic_category(), "shm cache: lock");
+        }
+    }
+
+    class Guard {
+    private:
+        ShmARCSegment& segment;
+
+    public:
+        explicit Guard(ShmARCSegment& segment) : segment(segment) { segment.lock(); }
+        ~Guard() { pthread_mutex_unlock(&segment.header->lock); }
+    };
+
+    List& list(uint8_t id) { return header->lists[id]; }
+
+    void push_front(uint8_t id, uint32_t e) {
+        List& l = list(id);
+        entries[e].list = id;
+        entries[e].prev = NIL;
+        entries[e].next = l.head;
+        if (l.head != NIL) entries[l.head].prev = e;
+        else l.tail = e;
+        l.head = e;
+        l.size++;
+    }
+
+    void unlink(uint32_t e) {
+        List& l = list(entries[e].list);
+        if (entries[e].prev != NIL) entries[entries[e].prev].next = entries[e].next;
+        else l.head = entries[e].next;
+        if (entries[e].next != NIL) entries[entries[e].next].prev = entries[e].prev;
+        else l.tail = entries[e].prev;
+        l.size--;
+    }
+
+    bool resident(uint32_t e) const { return entries[e].list == T1 || entries[e].list == T2; }
+
+    uint32_t find(uint64_t hash, const char* key, size_t key_size) const {
+        for (uint32_t e = buckets[hash & (header->num_buckets - 1)]; e != NIL; e = entries[e].chain) {
+            const Entry& entry = entries[e];
+            if (entry.hash != hash) continue;
+            if (!resident(e)) return e; // ghosts are matched by hash alone
+            if (entry.key_size == key_size && std::memcmp(base + entry.chunk + CHUNK_HEADER, key, key_size) == 0) return e;
+        }
+        return NIL;
+    }
+
+    void index_insert(uint32_t e) {
+        uint32_t& bucket = buckets[entries[e].hash & (header->num_buckets - 1)];
+        entries[e].chain = bucket;
+        bucket = e;
+    }
+
+    void index_remove(uint32_t e) {
+        uint32_t* link = &buckets[entries[e].hash & (header->num_buckets - 1)];
+        while (*link != e) link = &entries[*link].chain;
+        *link = entries[e].chain;
+    }
+
+    // Slab chunks. The first word of a free chunk links to the next free chunk of its class
+    // and the second to the previous one, so a page's chunks can leave the list in O(1)
+    // each; the first word of a used chunk is OWNED | its entry.
+    int class_for(size_t size) const {
+        size += CHUNK_HEADER;
+        for (size_t c = 0; c < header->num_classes; c++) {
+            if (header->class_size[c] >= size) return static_cast<int>(c);
+        }
+        return -1;
+    }
+
+    uint64_t word(uint64_t chunk, size_t at) const {
+        uint64_t value;
+        std::memcpy(&value, base + chunk + at, sizeof(uint64_t));
+        return value;
+    }
+
+    void set_word(uint64_t chunk, size_t at, uint64_t value) {
+        std::memcpy(base + chunk + at, &value, sizeof(uint64_t));
+    }
+
+    Page& page_of(uint64_t chunk) {
+        return pages[(chunk - header->pages_at) / PAGE_BYTES];
+    }
+
+    void push_free(uint8_t cls, uint64_t chunk) {
+        uint64_t head = header->class_free[cls];
+        set_word(chunk, 0, head);
+        set_word(chunk, sizeof(uint64_t), NO_CHUNK);
+        if (head != NO_CHUNK) set_word(head, sizeof(uint64_t), chunk);
+        header->class_free[cls] = chunk;
+    }
+
+    void unlink_free(uint8_t cls, uint64_t chunk) {
+        uint64_t next = word(chunk, 0), prev = word(chunk, sizeof(uint64_t));
+        if (prev != NO_CHUNK) set_word(prev, 0, next);
+        else header->class_free[cls] = next;
+        if (next != NO_CHUNK) set_word(next, sizeof(uint64_t), prev);
+    }
+
+    void free_chunk(uint8_t cls, uint64_t chunk) {
+        push_free(cls, chunk);
+        page_of(chunk).used--;
+    }
+
+    // Cuts page number p into free chunks of class cls
+    void assign_page(uint64_t p, uint8_t cls) {
+        pages[p] = Page{0, cls};
+        header->class_pages[cls]++;
+        uint64_t page = header->pages_at + p * PAGE_BYTES;
+        uint64_t size = header->class_size[cls];
+        for (uint64_t at = page + (PAGE_BYTES / size) * size; at > page;) push_free(cls, at -= size);
+    }
+
+    uint64_t take_chunk(uint8_t cls) {
+        if (header->class_free[cls] == NO_CHUNK) {
+            if (header->pages_used == header->num_pages) return NO_CHUNK;
+            assign_page(header->pages_used++, cls);
+        }
+        uint64_t chunk = header->class_free[cls];
+        unlink_free(cls, chunk);
+        set_word(chunk, 0, OWNED | NIL); // store() sets the owner
+        page_of(chunk).used++;
+        return chunk;
+    }
+
+    // The list ARC's replace() takes its next victim from, and the other one
+    void eviction_order(uint8_t order[2]) const {
+        const List& t1 = header->lists[T1];
+        bool from_t1 = t1.size && (t1.size > header->p || header->lists[T2].size == 0);
+        order[0] = from_t1 ? T1 : T2;
+        order[1] = from_t1 ? T2 : T1;
+    }
+
+    // Moves a page from another class to cls: the emptiest page of the class that ARC's next
+    // victim belongs to, or of any other class if that one is cls. Its residents become
+    // ghosts. Returns false if every page already belongs to cls.
+    bool reassign_page(uint8_t cls, uint32_t keep) {
+        uint8_t order[2];
+        eviction_order(order);
+        uint32_t coldest = NIL;
+        for (uint8_t id : order) {
+            for (uint32_t e = list(id).tail; e != NIL && coldest == NIL; e = entries[e].prev) {
+                if (e != keep && entries[e].chunk != NO_CHUNK) coldest = e;
+            }
+        }
+        uint32_t from = coldest != NIL ? entries[coldest].slab_class : cls;
+        uint64_t donor = header->num_pages;
+        for (int pass = 0; pass < 2 && donor == header->num_pages; pass++) {
+            for (uint64_t p = 0; p < header->pages_used; p++) {
+                uint32_t owner = pages[p].slab_class;
+                if (owner == cls || (pass == 0 && owner != from)) continue;
+                if (donor == header->num_pages || pages[p].used < pages[donor].used) donor = p;
+            }
+        }
+        if (donor == header->num_pages) return false;
+
+        from = pages[donor].slab_class;
+        uint64_t page = header->pages_at + donor * PAGE_BYTES;
+        uint64_t size = header->class_size[from];
+        uint64_t end = page + (PAGE_BYTES / size) * size;
+        for (uint64_t at = page; at < end; at += size) {
+            uint64_t owner = word(at, 0);
+            if ((owner & ~uint64_t(UINT32_MAX)) == OWNED) demote(static_cast<uint32_t>(owner));
+        }
+        for (uint64_t at = page; at < end; at += size) unlink_free(static_cast<uint8_t>(from), at);
+        header->class_pages[from]--;
+        assign_page(donor, cls);
+        header->stats.reassigned++;
+        return true;
+    }
+
+    // A chunk of class cls. Without a free one, it demotes the least recently used resident
+    // of cls among the MAX_SEARCH nearest ARC's eviction end of each list (never `keep`), and
+    // failing that moves a page over from another class.
+    uint64_t alloc_chunk(uint8_t cls, uint32_t keep) {
+        uint64_t chunk = take_chunk(cls);
+        if (chunk != NO_CHUNK) return chunk;
+        uint8_t order[2];
+        eviction_order(order);
+        for (uint8_t id : order) {
+            size_t searched = 0;
+            for (uint32_t e = list(id).tail; e != NIL && searched < MAX_SEARCH; e = entries[e].prev, searched++) {
+                if (e != keep && entries[e].chunk != NO_CHUNK && entries[e].slab_class == cls) {
+                    demote(e);
+                    return take_chunk(cls);
+                }
+            }
+        }
+        return reassign_page(cls, keep) ? take_chunk(cls) : NO_CHUNK;
+    }
+
+    uint32_t new_entry() {
+        if (header->free_entries == NIL) {
+            // Only reachable if memory-driven evictions overfilled the ghost lists
+            drop(list(B1).size >= list(B2).size ? list(B1).tail : list(B2).tail);
+        }
+        uint32_t e = header->free_entries;
+        header->free_entries = entries[e].next;
+        return e;
+    }
+
+    // Removes an entry that is in no list from the index and frees it
+    void release(uint32_t e) {
+        index_remove(e);
+        if (entries[e].chunk != NO_CHUNK) free_chunk(entries[e].slab_class, entries[e].chunk);
+        entries[e].list = FREE;
+        entries[e].next = header->free_entries;
+        header->free_entries = e;
+    }
+
+    // Removes an entry from the cache and the directory altogether
+    void drop(uint32_t e) {
+        unlink(e);
+        release(e);
+    }
+
+    // ARC's replace(): demotes the LRU entry of T1 or T2 to B1 or B2. Returns false if
+    // nothing is resident or the victim would be `keep`.
+    bool replace(bool in_b2, uint32_t keep = NIL) {
+        List& t1 = list(T1);
+        List& t2 = list(T2);
+        uint32_t victim;
+        if (t1.size && (t1.size > header->p || (in_b2 && t1.size == header->p) || t2.size == 0)) {
+            victim = t1.tail;
+        } else if (t2.size) {
+            victim = t2.tail;
+        } else {
+            return false;
+        }
+        if (victim == keep) return false;
+        demote(victim);
+        return true;
+    }
+
+    // Turns a resident entry into a ghost in B1 (from T1) or B2 (from T2), freeing its chunk
+    void demote(uint32_t e) {
+        uint8_t ghosts = entries[e].list == T1 ? B1 : B2;
+        unlink(e);
+        free_chunk(entries[e].slab_class, entries[e].chunk);
+        entries[e].chunk = NO_CHUNK;
+        push_front(ghosts, e);
+        if (ghosts == B2 && list(B2).size > header->capacity) drop(list(B2).tail);
+    }
+
+    // Frees a directory slot for a key in none of the four lists (Case 5 of ARCache::put)
+    void make_room() {
+        uint64_t c = header->capacity;
+        uint64_t t1 = list(T1).size, t2 = list(T2).size, b1 = list(B1).size, b2 = list(B2).size;
+        if (t1 + b1 >= c) {
+            if (t1 < c) {
+                if (b1) drop(list(B1).tail);
+                replace(false);
+            } else {
+                drop(list(T1).tail);
+            }
+        } else if (t1 + t2 + b1 + b2 >= c) {
+            if (t1 + t2 + b1 + b2 == 2 * c && b2) drop(list(B2).tail);
+            replace(false);
+        }
+    }
+
+    void store(uint32_t e, uint64_t chunk, uint8_t cls, const char* key, size_t key_size,
+               const char* value, size_t value_size) {
+        entries[e].chunk = chunk;
+        entries[e].slab_class = cls;
+        entries[e].key_size = static_cast<uint32_t>(key_size);
+        entries[e].value_size = static_cast<uint32_t>(value_size);
+        set_word(chunk, 0, OWNED | e);
+        std::memcpy(base + chunk + CHUNK_HEADER, key, key_size);
+        std::memcpy(base + chunk + CHUNK_HEADER + key_size, value, value_size);
+    }
+
+public:
+    // Opens the segment called name (e.g. "/arc-cache"), creating and formatting it if it
+    // does not exist yet. capacity is the number of resident entries; memory_bytes, rounded
+    // down to whole slab pages, bounds the bytes of keys and values.
+    ShmARCSegment(const std::string& name, size_t capacity, size_t memory_bytes)
+        : name(name), base(nullptr), bytes(0), header(nullptr), entries(nullptr), buckets(nullptr), pages(nullptr) {
+        Layout layout = layout_for(capacity, memory_bytes);
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        bool creator = fd >= 0;
+        if (!creator) {
+            if (errno != EEXIST) throw error("shm_open " + name);
+            fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+            if (fd < 0) throw error("shm_open " + name);
+        }
+        try {
+            if (creator) {
+                if (::ftruncate(fd, static_cast<off_t>(layout.bytes)) != 0) throw error("ftruncate " + name);
+            } else {
+                // The creator may not have sized it yet
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                struct stat st;
+                while (true) {
+                    if (::fstat(fd, &st) != 0) throw error("fstat " + name);
+                    if (st.st_size != 0) break;
+                    if (std::chrono::steady_clock::now() > deadline) throw std::runtime_error("shm cache: " + name + " was never sized");
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                if (static_cast<uint64_t>(st.st_size) != layout.bytes) {
+                    throw std::invalid_argument("shm cache: " + name + " exists with a different capacity or memory size");
+                }
+            }
+            void* mapped = ::mmap(nullptr, layout.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) throw error("mmap " + name);
+            base = static_cast<char*>(mapped);
+            bytes = layout.bytes;
+        } catch (...) {
+            ::close(fd);
+            if (creator) ::shm_unlink(name.c_str());
+            throw;
+        }
+        ::close(fd);
+        header = reinterpret_cast<Header*>(base);
+        entries = reinterpret_cast<Entry*>(base + layout.entries_at);
+        buckets = reinterpret_cast<uint32_t*>(base + layout.buckets_at);
+        pages = reinterpret_cast<Page*>(base + layout.page_table_at);
+
+        if (creator) {
+            format(layout);
+            __atomic_store_n(&header->magic, MAGIC, __ATOMIC_RELEASE);
+            return;
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != MAGIC) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                ::munmap(base, bytes);
+                throw std::runtime_error("shm cache: " + name + " was never formatted");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (header->capacity != layout.capacity || header->num_pages != layout.num_pages) {
+            ::munmap(base, bytes);
+            throw std::invalid_argument("shm cache: " + name + " exists with a different capacity or memory size");
+        }
+    }
+
+    ~ShmARCSegment() {
+        ::munmap(base, bytes);
+    }
+
+    ShmARCSegment(const ShmARCSegment&) = delete;
+    ShmARCSegment& operator=(const ShmARCSegment&) = delete;
+
+    // Unlinks the segment; processes that have it mapped keep using it
+    static void remove(const std::string& name) {
+        ::shm_unlink(name.c_str());
+    }
+
+    // Returns false if the item is larger than a slab page or no chunk could be freed for it
+    bool put(const char* key, size_t key_size, const char* value, size_t value_size) {
+        int cls = class_for(key_size + value_size);
+        Guard guard(*this);
+        if (cls < 0) {
+            header->stats.rejected++;
+            return false;
+        }
+        uint64_t hash = hash_of(key, key_size);
+        uint32_t e = find(hash, key, key_size);
+
+        // Case 1 and 2: resident, moves to the MRU end of T2 with the new value
+        if (e != NIL && resident(e)) {
+            unlink(e);
+            push_front(T2, e);
+            uint64_t chunk = entries[e].chunk;
+            if (entries[e].slab_class != cls) {
+                free_chunk(entries[e].slab_class, chunk);
+                entries[e].chunk = NO_CHUNK;
+                chunk = alloc_chunk(static_cast<uint8_t>(cls), e);
+                if (chunk == NO_CHUNK) {
+                    drop(e);
+                    header->stats.rejected++;
+                    return false;
+                }
+            }
+            store(e, chunk, static_cast<uint8_t>(cls), key, key_size, value, value_size);
+            return true;
+        }
+
+        // Case 3 and 4: a ghost hit adapts p, then the key returns straight to T2
+        if (e != NIL) {
+            uint64_t b1 = list(B1).size, b2 = list(B2).size;
+            bool in_b2 = entries[e].list == B2;
+            if (!in_b2) {
+                double delta = std::max(1.0, static_cast<double>(b2) / std::max<uint64_t>(1, b1));
+                header->p = std::min<uint64_t>(header->capacity, static_cast<uint64_t>(header->p + delta));
+            } else {
+                double delta = std::max(1.0, static_cast<double>(b1) / std::max<uint64_t>(1, b2));
+                header->p = header->p >= delta ? static_cast<uint64_t>(header->p - delta) : 0;
+            }
+            unlink(e); // first, so that trimming B2 in replace() cannot free it
+            replace(in_b2);
+            uint64_t chunk = alloc_chunk(static_cast<uint8_t>(cls), NIL);
+            if (chunk == NO_CHUNK) {
+                release(e);
+                header->stats.rejected++;
+                return false;
+            }
+            push_front(T2, e);
+            store(e, chunk, static_cast<uint8_t>(cls), key, key_size, value, value_size);
+            return true;
+        }
+
+        // Case 5: not in the directory, enters T1
+        make_room();
+        uint64_t chunk = alloc_chunk(static_cast<uint8_t>(cls), NIL);
+        if (chunk == NO_CHUNK) {
+            header->stats.rejected++;
+            return false;
+        }
+        e = new_entry();
+        entries[e].hash = hash;
+        index_insert(e);
+        push_front(T1, e);
+        store(e, chunk, static_cast<uint8_t>(cls), key, key_size, value, value_size);
+        return true;
+    }
+
+    // Copies the value out on a hit, which moves the key to the MRU end of T2
+    bool get(const char* key, size_t key_size, std::string& value) {
+        Guard guard(*this);
+        uint32_t e = find(hash_of(key, key_size), key, key_size);
+        if (e == NIL || !resident(e)) {
+            header->stats.misses++;
+            return false;
+        }
+        header->stats.hits++;
+        value.assign(base + entries[e].chunk + CHUNK_HEADER + entries[e].key_size, entries[e].value_size);
+        unlink(e);
+        push_front(T2, e);
+        return true;
+    }
+
+    // Removes key if it is resident, without leaving a ghost entry
+    bool erase(const char* key, size_t key_size) {
+        Guard guard(*this);
+        uint32_t e = find(hash_of(key, key_size), key, key_size);
+        if (e == NIL || !resident(e)) return false;
+        drop(e);
+        return true;
+    }
+
+    size_t size() {
+        Guard guard(*this);
+        return list(T1).size + list(T2).size;
+    }
+
+    void clear() {
+        Guard guard(*this);
+        reset();
+    }
+
+    SharedARCStats stats() {
+        Guard guard(*this);
+        return header->stats;
+    }
+
+    size_t capacity() const { return header->capacity; }
+    size_t segment_bytes() const { return bytes; }
+
+    // Slab pages handed out count as entries; the header, entry array and buckets as index
+    MemoryUsage memory_usage() {
+        Guard guard(*this);
+        MemoryUsage usage;
+        usage.entries = header->pages_used * PAGE_BYTES;
+        usage.index = header->pages_at;
+        return usage;
+    }
+};
+
+// Typed front end: keys and values are encoded with Serializer, so any type it supports
+// can be shared between processes built from the same sources.
+template<typename K, typename V>
+class SharedARCache final : public Cache<K, V> {
+private:
+    mutable ShmARCSegment segment;
+
+public:
+    SharedARCache(const std::string& name, size_t capacity, size_t memory_bytes = size_t(64) << 20)
+        : segment(name, capacity, memory_bytes) {}
+
+    static void remove(const std::string& name) {
+        ShmARCSegment::remove(name);
+    }
+
+    void put(const K& key, const V& value) override {
+        std::string k, v;
+        Serializer<K>::write(key, k);
+        Serializer<V>::write(value, v);
+        segment.put(k.data(), k.size(), v.data(), v.size());
+    }
+
+    bool get(const K& key, V& value) override {
+        std::string k, bytes;
+        Serializer<K>::write(key, k);
+        if (!segment.get(k.data(), k.size(), bytes)) return false;
+        value = Serializer<V>::read(bytes.data(), bytes.size());
+        return true;
+    }
+
+    bool erase(const K& key) {
+        std::string k;
+        Serializer<K>::write(key, k);
+        return segment.erase(k.data(), k.size());
+    }
+
+    size_t size() const override {
+        return segment.size();
+    }
+
+    void clear() override {
+        segment.clear();
+    }
+
+    SharedARCStats stats() const {
+        return segment.stats();
+    }
+
+    size_t segment_bytes() const {
+        return segment.segment_bytes();
+    }
+
+    MemoryUsage memory_usage() const override {
+        return segment.memory_usage();
+    }
+};
+
+#endif // SHM_ARC_CACHE_HPP
@@ -0,0 +1,159 @@
+#include "arc_cache.hpp"
+#include "shm_arc_cache.hpp"
+#include "workload.hpp"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Worker processes doing cache-aside over the same Zipf key space, each with its own
+// ARCache versus all attached to one SharedARCache. With --kill, one worker of the shared
+// run is SIGKILLed partway through; if it held the lock, the others recover and go on.
+
+std::string value_for(int key, size_t size) {
+    std::string value(size, '\0');
+    for (size_t i = 0; i < size; i++) value[i] = static_cast<char>('a' + (key + i) % 26);
+    return value;
+}
+
+// Filled in by each worker, in memory shared with the parent
+struct WorkerResult {
+    uint64_t accesses;
+    uint64_t hits;
+    uint64_t corrupt;
+    uint64_t resident; // entries the worker's own cache held at the end (private run)
+    double seconds;
+};
+
+template<typename Cache>
+void drive(Cache& cache, PatternStream<ZipfianPattern> keys, size_t value_size, WorkerResult& result) {
+    std::vector<int> block(ACCESS_BLOCK_SIZE);
+    auto start = std::chrono::steady_clock::now();
+    while (size_t n = keys.next_block(block.data(), block.size())) {
+        for (size_t i = 0; i < n; i++) {
+            std::string value;
+            if (cache.get(block[i], value)) {
+                result.hits++;
+                if (value != value_for(block[i], value_size)) result.corrupt++;
+            } else {
+                cache.put(block[i], value_for(block[i], value_size));
+            }
+        }
+        result.accesses += n;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t processes = 8;
+    int data_range = 1000000;
+    size_t capacity = 100000;
+    size_t pattern_length = 1000000; // per process
+    size_t value_size = 100;
+    size_t memory_mb = 64;
+    bool kill_one = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--processes") == 0 && i + 1 < argc) {
+            processes = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            data_range = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            capacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--length") == 0 && i + 1 < argc) {
+            pattern_length = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--value-size") == 0 && i + 1 < argc) {
+            value_size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            memory_mb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--kill") == 0) {
+            kill_one = true;
+        }
+    }
+    std::string name = "/shm_bench." + std::to_string(::getpid());
+
+    void* shared = ::mmap(nullptr, processes * sizeof(WorkerResult), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        std::perror("mmap");
+        return 1;
+    }
+    WorkerResult* results = static_cast<WorkerResult*>(shared);
+    auto stream = make_stream(ZipfianPattern(data_range, 0.99), pattern_length * processes);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << processes << " processes, Zipf(0.99) over " << data_range << " keys, " << pattern_length
+              << " accesses each, capacity " << capacity << ", value size " << value_size << "\n";
+    std::cout << "Cache\t\tHit Rate (%)\tKops/s\tResident entries\n";
+    for (bool use_shared : {false, true}) {
+        std::memset(results, 0, processes * sizeof(WorkerResult));
+        std::unique_ptr<SharedARCache<int, std::string>> owner;
+        if (use_shared) {
+            try {
+                owner = std::make_unique<SharedARCache<int, std::string>>(name, capacity, memory_mb << 20);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        }
+        std::vector<pid_t> workers;
+        for (size_t w = 0; w < processes; w++) {
+            pid_t pid = ::fork();
+            if (pid < 0) {
+                std::perror("fork");
+                return 1;
+            }
+            if (pid == 0) {
+                try {
+                    if (use_shared) {
+                        SharedARCache<int, std::string> cache(name, capacity, memory_mb << 20);
+                        drive(cache, stream.split(processes, w), value_size, results[w]);
+                    } else {
+                        ARCache<int, std::string> cache(capacity);
+                        drive(cache, stream.split(processes, w), value_size, results[w]);
+                        results[w].resident = cache.size();
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << e.what() << "\n";
+                    ::_exit(1);
+                }
+                ::_exit(0);
+            }
+            workers.push_back(pid);
+        }
+        if (use_shared && kill_one) {
+            ::usleep(200000);
+            ::kill(workers[0], SIGKILL);
+        }
+        for (pid_t pid : workers) ::waitpid(pid, nullptr, 0);
+
+        uint64_t accesses = 0, hits = 0, corrupt = 0, resident = 0;
+        double seconds = 0;
+        for (size_t w = 0; w < processes; w++) {
+            accesses += results[w].accesses;
+            hits += results[w].hits;
+            corrupt += results[w].corrupt;
+            resident += results[w].resident;
+            seconds = std::max(seconds, results[w].seconds);
+        }
+        if (use_shared) resident = owner->size();
+        std::cout << (use_shared ? "Shared ARC\t" : "Private ARCs\t") << 100.0 * hits / accesses << "%\t\t"
+                  << accesses / seconds / 1e3 << "\t" << resident << "\n";
+        if (corrupt) std::cerr << corrupt << " hits returned a wrong value\n";
+        if (use_shared) {
+            SharedARCStats stats = owner->stats();
+            std::cout << "Segment: " << owner->segment_bytes() / 1e6 << " MB, rejected puts: " << stats.rejected
+                      << ", pages moved: " << stats.reassigned << ", lock recoveries: " << stats.recoveries << "\n";
+            SharedARCache<int, std::string>::remove(name);
+        }
+    }
+    ::munmap(shared, processes * sizeof(WorkerResult));
+    return 0;
+}
@@ -0,0 +1,256 @@
+#ifndef SIEVE_CACHE_HPP
+#define SIEVE_CACHE_HPP
+
+#include "cache.hpp"
+#include <unordered_map>
+#include <list>
+#include <atomic>
+#include <mutex>
+
+// SIEVE (Zhang et al., NSDI 2024): one FIFO queue, a visited bit per entry and a hand that
+// sweeps from the oldest entry towards the newest. A hit only sets the visited bit; the hand
+// clears bits as it passes and evicts the first entry it finds unvisited.
+// SieveQueue holds the logic for one thread; the flag type decides whether the bit is atomic.
+inline bool sieve_test(const bool& flag) { return flag; }
+inline void sieve_set(bool& flag, bool value) { flag = value; }
+inline bool sieve_test(const std::atomic<bool>& flag) { return flag.load(std::memory_order_relaxed); }
+inline void sieve_set(std::atomic<bool>& flag, bool value) { flag.store(value, std::memory_order_relaxed); }
+
+template<typename K, typename V, typename Flag>
+struct SieveNode {
+    K key;
+    V value;
+    Flag visited;
+
+    SieveNode(const K& key, const V& value) : key(key), value(value), visited(false) {}
+};
+
+// Moves the hand to the first unvisited entry, clearing bits on the way, and returns it as
+// the victim; the hand is left on the entry after it. queue is front-newest and not empty.
+template<typename List>
+typename List::iterator sieve_sweep(List& queue, typename List::iterator& hand) {
+    auto it = hand == queue.end() ? std::prev(queue.end()) : hand;
+    while (sieve_test(it->visited)) {
+        sieve_set(it->visited, false);
+        it = it == queue.begin() ? std::prev(queue.end()) : std::prev(it);
+    }
+    hand = it == queue.begin() ? queue.end() : std::prev(it);
+    return it;
+}
+
+template<typename K, typename V, typename Flag>
+class SieveQueue {
+private:
+    using Node = SieveNode<K, V, Flag>;
+    using List = std::list<Node, CountingAllocator<Node>>;
+    using Index = std::unordered_map<K, typename List::iterator, std::hash<K>, std::equal_to<K>,
+                                     CountingAllocator<std::pair<const K, typename List::iterator>>>;
+
+    size_t capacity;
+    MemoryCounter entry_bytes; // declared before the containers that report to them
+    MemoryCounter index_bytes;
+    List queue;                    // front is the newest entry, back the oldest
+    Index map;
+    typename List::iterator hand;  // queue.end() when the next sweep starts from the oldest entry
+
+    void evict() {
+        auto it = sieve_sweep(queue, hand);
+        map.erase(it->key);
+        queue.erase(it);
+    }
+
+public:
+    explicit SieveQueue(size_t size)
+        : capacity(size), queue(CountingAllocator<Node>(&entry_bytes)),
+          map(CountingAllocator<Node>(&index_bytes)), hand(queue.end()) {}
+
+    // Returns the node for key, or nullptr; marks it visited
+    Node* find(const K& key) {
+        auto it = map.find(key);
+        if (it == map.end()) {
+            return nullptr;
+        }
+        Node& node = *it->second;
+        if (!sieve_test(node.visited)) sieve_set(node.visited, true); // skip the store when already set
+        return &node;
+    }
+
+    void put(const K& key, const V& value) {
+        if (capacity == 0) return;
+        if (Node* node = find(key)) {
+            node->value = value;
+            return;
+        }
+        if (queue.size() >= capacity) {
+            evict();
+        }
+        queue.emplace_front(key, value);
+        map.emplace(key, queue.begin());
+    }
+
+    size_t size() const {
+        return queue.size();
+    }
+
+    void clear() {
+        map.clear();
+        queue.clear();
+        hand = queue.end();
+    }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.index = index_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead + index_bytes.overhead;
+        return usage;
+    }
+};
+
+template<typename K, typename V>
+class SieveCache final : public Cache<K, V> {
+private:
+    SieveQueue<K, V, bool> sieve;
+
+public:
+    explicit SieveCache(size_t size) : sieve(size) {}
+
+    void put(const K& key, const V& value) override {
+        sieve.put(key, value);
+    }
+
+    bool get(const K& key, V& value) override {
+        auto node = sieve.find(key);
+        if (!node) {
+            return false;
+        }
+        value = node->value;
+        return true;
+    }
+
+    size_t size() const override {
+        return sieve.size();
+    }
+
+    void clear() override {
+        sieve.clear();
+    }
+
+    MemoryUsage memory_usage() const override {
+        return sieve.memory_usage();
+    }
+};
+
+// Thread-safe SIEVE. Since a hit never moves an entry, it needs only the index: the index is
+// split into STRIPES hash maps, each behind its own mutex, and a hit locks just its key's
+// stripe, looks the key up, copies the value and records the hit with one relaxed store to
+// the visited bit. Hits on different stripes share no lock. Misses that insert take the
+// queue mutex, which orders the hand and evictions, and then the stripe of each key whose
+// index entry they add or remove; a node is unlinked from its stripe before it is freed.
+template<typename K, typename V>
+class ConcurrentSieveCache final : public Cache<K, V> {
+private:
+    static const size_t STRIPES = 64;
+
+    using Node = SieveNode<K, V, std::atomic<bool>>;
+    using List = std::list<Node, CountingAllocator<Node>>;
+    using Index = std::unordered_map<K, typename List::iterator, std::hash<K>, std::equal_to<K>,
+                                     CountingAllocator<std::pair<const K, typename List::iterator>>>;
+
+    struct alignas(64) Stripe { // one per cache line, so stripes locked by different threads do not share one
+        mutable std::mutex mutex;
+        MemoryCounter bytes;
+        Index map;
+
+        Stripe() : map(CountingAllocator<Node>(&bytes)) {}
+    };
+
+    size_t capacity;
+    mutable std::mutex mutex;      // guards the queue and the hand
+    MemoryCounter entry_bytes;
+    List queue;                    // front is the newest entry, back the oldest
+    typename List::iterator hand;  // queue.end() when the next sweep starts from the oldest entry
+    Stripe stripes[STRIPES];
+
+    Stripe& stripe_for(const K& key) {
+        return stripes[std::hash<K>()(key) % STRIPES];
+    }
+
+    void evict() {
+        auto it = sieve_sweep(queue, hand);
+        Stripe& stripe = stripe_for(it->key);
+        {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            stripe.map.erase(it->key);
+        }
+        queue.erase(it);
+    }
+
+public:
+    explicit ConcurrentSieveCache(size_t size)
+        : capacity(size), queue(CountingAllocator<Node>(&entry_bytes)), hand(queue.end()) {}
+
+    void put(const K& key, const V& value) override {
+        if (capacity == 0) return;
+        Stripe& stripe = stripe_for(key);
+        std::lock_guard<std::mutex> lock(mutex);
+        {
+            std::lock_guard<std::mutex> stripe_lock(stripe.mutex);
+            auto it = stripe.map.find(key);
+            if (it != stripe.map.end()) {
+                it->second->value = value;
+                sieve_set(it->second->visited, true);
+                return;
+            }
+        }
+        if (queue.size() >= capacity) {
+            evict();
+        }
+        queue.emplace_front(key, value);
+        std::lock_guard<std::mutex> stripe_lock(stripe.mutex);
+        stripe.map.emplace(key, queue.begin());
+    }
+
+    bool get(const K& key, V& value) override {
+        Stripe& stripe = stripe_for(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto it = stripe.map.find(key);
+        if (it == stripe.map.end()) {
+            return false;
+        }
+        Node& node = *it->second;
+        if (!sieve_test(node.visited)) sieve_set(node.visited, true); // skip the store when already set
+        value = node.value;
+        return true;
+    }
+
+    size_t size() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.size();
+    }
+
+    void clear() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Stripe& stripe : stripes) {
+            std::lock_guard<std::mutex> stripe_lock(stripe.mutex);
+            stripe.map.clear();
+        }
+        queue.clear();
+        hand = queue.end();
+    }
+
+    MemoryUsage memory_usage() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead;
+        for (const Stripe& stripe : stripes) {
+            std::lock_guard<std::mutex> stripe_lock(stripe.mutex);
+            usage.index += stripe.bytes.bytes;
+            usage.allocator_overhead += stripe.bytes.overhead;
+        }
+        return usage;
+    }
+};
+
+#endif // SIEVE_CACHE_HPP
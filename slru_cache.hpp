@@ -0,0 +1,95 @@
+#ifndef SLRU_CACHE_HPP
+#define SLRU_CACHE_HPP
+
+#include "lru_cache.hpp"
+#include <algorithm>
+
+// Segmented LRU (Karedla et al., 1994). New keys enter the probationary segment; a second
+// hit promotes them to the protected segment (80% of the capacity), whose overflow is
+// demoted back to the head of probationary. Eviction only takes from probationary, so a
+// scan of one-time keys cannot displace anything that has been hit twice.
+template<typename K, typename V>
+class SLRUCache final : public Cache<K, V> {
+private:
+    size_t capacity;
+    size_t protected_capacity;
+
+    MemoryCounter entry_bytes; // declared before the containers that report to them
+    MemoryCounter index_bytes;
+
+    LRUList<K, V> probationary;
+    LRUList<K, V> protected_;
+
+    void promote(typename LRUList<K, V>::iterator it) {
+        protected_.take(probationary, it);
+        if (protected_.size() > protected_capacity) {
+            probationary.take(protected_, std::prev(protected_.end()));
+        }
+    }
+
+public:
+    explicit SLRUCache(size_t size)
+        : capacity(size), protected_capacity(size - std::min(size, std::max<size_t>(1, size / 5))),
+          probationary(&entry_bytes, &index_bytes), protected_(&entry_bytes, &index_bytes) {}
+
+    void put(const K& key, const V& value) override {
+        if (capacity == 0) return;
+
+        auto it = protected_.find(key);
+        if (it != protected_.end()) {
+            it->second = value;
+            protected_.touch(it);
+            return;
+        }
+        it = probationary.find(key);
+        if (it != probationary.end()) {
+            it->second = value;
+            promote(it);
+            return;
+        }
+
+        if (probationary.size() + protected_.size() >= capacity) {
+            if (!probationary.empty()) {
+                probationary.pop_back();
+            } else {
+                protected_.pop_back();
+            }
+        }
+        probationary.push_front(key, value);
+    }
+
+    bool get(const K& key, V& value) override {
+        auto it = protected_.find(key);
+        if (it != protected_.end()) {
+            value = it->second;
+            protected_.touch(it);
+            return true;
+        }
+        it = probationary.find(key);
+        if (it != probationary.end()) {
+            value = it->second;
+            promote(it);
+            return true;
+        }
+        return false;
+    }
+
+    size_t size() const override {
+        return probationary.size() + protected_.size();
+    }
+
+    void clear() override {
+        probationary.clear();
+        protected_.clear();
+    }
+
+    MemoryUsage memory_usage() const override {
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.index = index_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead + index_bytes.overhead;
+        return usage;
+    }
+};
+
+#endif // SLRU_CACHE_HPP
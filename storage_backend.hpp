@@ -0,0 +1,85 @@
+#ifndef STORAGE_BACKEND_HPP
+#define STORAGE_BACKEND_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using PageId = uint64_t;
+
+// Where a BufferPool reads pages from and writes dirty pages back to. Errors are
+// reported by throwing; a page that was never written reads as zeros.
+class StorageBackend {
+public:
+    virtual ~StorageBackend() = default;
+    virtual void read_page(PageId page, char* buffer, size_t page_size) = 0;
+    virtual void write_page(PageId page, const char* buffer, size_t page_size) = 0;
+    virtual void sync() {}
+};
+
+// Pages stored back to back in one file, page i at offset i * page_size, through
+// pread/pwrite. Short transfers and EINTR are retried; other failures throw std::system_error.
+class FileBackend : public StorageBackend {
+private:
+    int fd;
+
+    static std::system_error error(const std::string& what) {
+        return std::system_error(errno, std::generic_category(), what);
+    }
+
+public:
+    explicit FileBackend(const std::string& path, bool create = true)
+        : fd(::open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0644)) {
+        if (fd < 0) throw error("open " + path);
+    }
+
+    ~FileBackend() override {
+        ::close(fd);
+    }
+
+    FileBackend(const FileBackend&) = delete;
+    FileBackend& operator=(const FileBackend&) = delete;
+
+    void read_page(PageId page, char* buffer, size_t page_size) override {
+        off_t offset = static_cast<off_t>(page * page_size);
+        size_t done = 0;
+        while (done < page_size) {
+            ssize_t n = ::pread(fd, buffer + done, page_size - done, offset + static_cast<off_t>(done));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw error("pread");
+            }
+            if (n == 0) { // past the end of the file
+                std::memset(buffer + done, 0, page_size - done);
+                return;
+            }
+            done += static_cast<size_t>(n);
+        }
+    }
+
+    void write_page(PageId page, const char* buffer, size_t page_size) override {
+        off_t offset = static_cast<off_t>(page * page_size);
+        size_t done = 0;
+        while (done < page_size) {
+            ssize_t n = ::pwrite(fd, buffer + done, page_size - done, offset + static_cast<off_t>(done));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw error("pwrite");
+            }
+            done += static_cast<size_t>(n);
+        }
+    }
+
+    void sync() override {
+        if (::fdatasync(fd) != 0) throw error("fdatasync");
+    }
+};
+
+#endif // STORAGE_BACKEND_HPP
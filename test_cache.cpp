@@ -1,106 +1,128 @@
 #include "arc_cache.hpp"
 #include "lru_cache.hpp"
 #include "lfu_cache.hpp"
+#include "s3fifo_cache.hpp"
+#include "sieve_cache.hpp"
+#include "lirs_cache.hpp"
+#include "two_q_cache.hpp"
+#include "slru_cache.hpp"
+#include "lecar_cache.hpp"
+#include "belady_cache.hpp"
+#include "workload.hpp"
+#include "perf_counters.hpp"
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <random>
 #include <iomanip>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <cstring>
 
-// Helper function to measure cache hit rate
+// Helper function to measure cache hit rate; the source is consumed block by block.
+// When counters are given they only run while the cache is being driven, not while keys are generated.
 template<typename Cache>
-double test_cache_scenario(Cache& cache, const std::vector<int>& access_pattern) {
-    int hits = 0;
-    int total = 0;
-    
-    for (int key : access_pattern) {
-        int value;
-        if (cache.get(key, value)) {
-            hits++;
-        } else {
-            cache.put(key, key);
+double test_cache_scenario(Cache& cache, AccessSource& source, uint64_t* accesses = nullptr,
+                           PerfCounters* counters = nullptr, PerfSample* sample = nullptr) {
+    std::vector<int> block(ACCESS_BLOCK_SIZE);
+    uint64_t hits = 0;
+    uint64_t total = 0;
+
+    if (counters) {
+        counters->start();
+        counters->pause();
+    }
+    while (size_t n = source.next_block(block.data(), block.size())) {
+        if (counters) counters->resume();
+        for (size_t i = 0; i < n; i++) {
+            int key = block[i];
+            int value;
+            if (cache.get(key, value)) {
+                hits++;
+            } else {
+                cache.put(key, key);
+            }
         }
-        total++;
+        if (counters) counters->pause();
+        total += n;
     }
-    
-    return static_cast<double>(hits) / total;
-}
 
-// Helper function to generate access pattern that shows ARC's advantages
-// Random access pattern
-std::vector<int> generate_random_access_pattern(int data_range, int pattern_length, int seed = 42) {
-    std::vector<int> pattern;
-    std::mt19937 gen(seed);
-    std::uniform_int_distribution<> dist(0, data_range - 1);
-    for (int i = 0; i < pattern_length; i++) {
-        pattern.push_back(dist(gen));
-    }
-    return pattern;
+    if (counters && sample) *sample = counters->stop();
+    if (accesses) *accesses = total;
+    return total ? static_cast<double>(hits) / total : 0.0;
 }
 
-// Locality access pattern (sequential access with some randomness)
-std::vector<int> generate_locality_access_pattern(int data_range, int pattern_length, int locality_size, int seed = 42) {
-    std::vector<int> pattern;
-    std::mt19937 gen(seed);
-    std::uniform_int_distribution<> dist(0, data_range - locality_size);
-    std::uniform_int_distribution<> local_dist(0, locality_size - 1);
-    for (int i = 0; i < pattern_length; i++) {
-        int base = dist(gen);
-        pattern.push_back(base + local_dist(gen));
-    }
-    return pattern;
-}
+// Hit ratio of one cache resized between phases of the same workload, against a cache built
+// cold at each phase's capacity; resizing should keep the warm entries that still fit.
+struct ResizePhase {
+    size_t capacity;
+    double resized_hit_rate;
+    double cold_hit_rate;
+    size_t size_after; // at the end of the phase, once a shrink has been worked off
+};
 
-// Periodic access pattern
-std::vector<int> generate_periodic_access_pattern(int data_range, int pattern_length, int period, int seed = 42) {
-    std::vector<int> pattern;
-    for (int i = 0; i < pattern_length; i++) {
-        pattern.push_back((i % period) % data_range);
+template<typename C, typename Pattern>
+std::vector<ResizePhase> test_resize_scenario(const std::vector<size_t>& capacities, const Pattern& pattern,
+                                              size_t phase_length) {
+    std::vector<ResizePhase> phases;
+    C cache(capacities.front());
+    auto stream = make_stream(pattern, phase_length * capacities.size());
+    for (size_t i = 0; i < capacities.size(); i++) {
+        cache.resize(capacities[i]);
+        auto slice = stream.split(capacities.size(), i);
+        std::vector<int> keys = read_all(slice);
+        VectorSource resized(keys), cold(keys);
+        C fresh(capacities[i]);
+        ResizePhase phase{capacities[i], test_cache_scenario(cache, resized), test_cache_scenario(fresh, cold), 0};
+        phase.size_after = cache.size();
+        phases.push_back(phase);
     }
-    return pattern;
+    return phases;
 }
 
-// Zipfian access pattern
-std::vector<int> generate_zipfian_access_pattern(int data_range, int pattern_length, double skew, int seed = 42) {
-    std::vector<int> pattern;
-    std::mt19937 gen(seed);
-    double denom = 0.0;
-    for (int i = 1; i <= data_range; i++) {
-        denom += 1.0 / pow(i, skew);
-    }
-    std::vector<double> probabilities(data_range + 1, 0.0);
-    probabilities[0] = 0.0;
-    for (int i = 1; i <= data_range; i++) {
-        probabilities[i] = probabilities[i - 1] + (1.0 / pow(i, skew)) / denom;
-    }
-    std::uniform_real_distribution<> dist(0.0, 1.0);
-    for (int i = 0; i < pattern_length; i++) {
-        double p = dist(gen);
-        int low = 1, high = data_range;
-        while (low < high) {
-            int mid = (low + high) / 2;
-            if (probabilities[mid] >= p)
-                high = mid;
-            else
-                low = mid + 1;
+int main(int argc, char** argv) {
+    std::string trace_path; // --trace <file> replays a trace instead of the generated patterns
+    bool perf = false;      // --perf reports hardware counters per access
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--perf") == 0) {
+            perf = true;
         }
-        pattern.push_back(low - 1); // 索引从 0 开始
     }
-    return pattern;
-}
-int main() {
+
     const int DATA_RANGE = 1000;
     const int PATTERN_LENGTH = 10000;
     const std::vector<int> CACHE_SIZES = {50, 100, 200}; // 不同的缓存容量
     const std::vector<int> LOCALITY_SIZES = {10, 50, 100}; // 对于局部性访问模式
     const std::vector<int> PERIODS = {100, 200, 500}; // 对于周期性访问模式
     const std::vector<double> ZIPF_SKEWS = {0.5, 1.0, 1.5}; // 对于 Zipf 分布
+    const std::vector<int> SCAN_LENGTHS = {100, 300, 500}; // scans per SCAN_PERIOD accesses of Zipf(1.0)
+    const int SCAN_PERIOD = 1000;
     
     // 定义缓存策略名称和对应的构造函数
-    std::map<std::string, std::function<Cache<int, int>*(int)>> cache_factories = {
-        {"ARC", [](int size) { return new ARCache<int, int>(size); }},
-        {"LRU", [](int size) { return new LRUCache<int, int>(size); }},
-        {"LFU", [](int size) { return new LFUCache<int, int>(size); }}
+    std::map<std::string, std::function<std::unique_ptr<Cache<int, int>>(int)>> cache_factories = {
+        {"ARC", [](int size) { return std::make_unique<ARCache<int, int>>(size); }},
+        {"ARC-Bypass", [](int size) {
+            auto cache = std::make_unique<ARCache<int, int>>(size);
+            cache->set_scan_policy(ScanPolicy::Bypass);
+            return cache;
+        }},
+        {"ARC-AtLRU", [](int size) {
+            auto cache = std::make_unique<ARCache<int, int>>(size);
+            cache->set_scan_policy(ScanPolicy::InsertAtLRU);
+            return cache;
+        }},
+        {"LRU", [](int size) { return std::make_unique<LRUCache<int, int>>(size); }},
+        {"LFU", [](int size) { return std::make_unique<LFUCache<int, int>>(size); }},
+        {"S3FIFO", [](int size) { return std::make_unique<S3FIFOCache<int, int>>(size); }},
+        {"SIEVE", [](int size) { return std::make_unique<SieveCache<int, int>>(size); }},
+        {"LIRS", [](int size) { return std::make_unique<LIRSCache<int, int>>(size); }},
+        {"2Q", [](int size) { return std::make_unique<TwoQCache<int, int>>(size); }},
+        {"SLRU", [](int size) { return std::make_unique<SLRUCache<int, int>>(size); }},
+        {"LeCaR", [](int size) { return std::make_unique<LeCaRCache<int, int>>(size); }}
     };
     
     // 存储实验结果
@@ -109,53 +131,135 @@ int main() {
         int cache_size;
         std::string cache_type;
         double hit_rate;
+        uint64_t accesses;
+        PerfSample perf;
     };
     std::vector<Result> results;
+
+    PerfCounters counters;
+    if (perf && !counters.available()) {
+        std::cerr << "perf counters unavailable (check /proc/sys/kernel/perf_event_paranoid)\n";
+        perf = false;
+    }
+
+    // Runs one policy over one access source, under the hardware counters when requested
+    auto run = [&](const std::string& pattern_type, int cache_size, const std::string& cache_type,
+                   Cache<int, int>& cache, AccessSource& source) {
+        Result result{pattern_type, cache_size, cache_type, 0.0, 0, PerfSample()};
+        result.hit_rate = test_cache_scenario(cache, source, &result.accesses,
+                                              perf ? &counters : nullptr, &result.perf);
+        results.push_back(result);
+    };
+
+    // Replays the same accesses against Belady's MIN, the upper bound for every policy. Each
+    // pattern's trace is read and prepared once, at the first capacity, and reused after that.
+    std::map<std::string, std::shared_ptr<const BeladyTrace<int>>> oracle_traces;
+    auto run_optimal = [&](const std::string& pattern_type, int cache_size, AccessSource& source) {
+        auto& trace = oracle_traces[pattern_type];
+        if (!trace) trace = std::make_shared<const BeladyTrace<int>>(read_all(source));
+        BeladyCache<int, int> oracle(cache_size, trace);
+        VectorSource replay(trace->keys);
+        run(pattern_type, cache_size, "OPT", oracle, replay);
+    };
     
     // 运行实验
     for (const auto& cache_size : CACHE_SIZES) {
+        if (!trace_path.empty()) {
+            for (const auto& cache_pair : cache_factories) {
+                auto cache = cache_pair.second(cache_size);
+                TraceFileSource source(trace_path);
+                run("Trace", cache_size, cache_pair.first, *cache, source);
+            }
+            {
+                TraceFileSource source(trace_path);
+                run_optimal("Trace", cache_size, source);
+            }
+            continue;
+        }
         // 测试随机访问模式
         {
-            std::vector<int> access_pattern = generate_random_access_pattern(DATA_RANGE, PATTERN_LENGTH);
+            RandomPattern pattern(DATA_RANGE);
             for (const auto& cache_pair : cache_factories) {
-                Cache<int, int>* cache = cache_pair.second(cache_size);
-                double hit_rate = test_cache_scenario(*cache, access_pattern);
-                results.push_back({"Random", cache_size, cache_pair.first, hit_rate});
-                delete cache;
+                auto cache = cache_pair.second(cache_size);
+                auto source = make_stream(pattern, PATTERN_LENGTH);
+                run("Random", cache_size, cache_pair.first, *cache, source);
+            }
+            {
+                auto source = make_stream(pattern, PATTERN_LENGTH);
+                run_optimal("Random", cache_size, source);
             }
         }
         // 测试局部性访问模式
         for (const auto& locality_size : LOCALITY_SIZES) {
-            std::vector<int> access_pattern = generate_locality_access_pattern(DATA_RANGE, PATTERN_LENGTH, locality_size);
+            LocalityPattern pattern(DATA_RANGE, locality_size);
             for (const auto& cache_pair : cache_factories) {
-                Cache<int, int>* cache = cache_pair.second(cache_size);
-                double hit_rate = test_cache_scenario(*cache, access_pattern);
-                results.push_back({"Locality(" + std::to_string(locality_size) + ")", cache_size, cache_pair.first, hit_rate});
-                delete cache;
+                auto cache = cache_pair.second(cache_size);
+                auto source = make_stream(pattern, PATTERN_LENGTH);
+                run("Locality(" + std::to_string(locality_size) + ")", cache_size, cache_pair.first, *cache, source);
+            }
+            {
+                auto source = make_stream(pattern, PATTERN_LENGTH);
+                run_optimal("Locality(" + std::to_string(locality_size) + ")", cache_size, source);
             }
         }
         // 测试周期性访问模式
         for (const auto& period : PERIODS) {
-            std::vector<int> access_pattern = generate_periodic_access_pattern(DATA_RANGE, PATTERN_LENGTH, period);
+            PeriodicPattern pattern(DATA_RANGE, period);
             for (const auto& cache_pair : cache_factories) {
-                Cache<int, int>* cache = cache_pair.second(cache_size);
-                double hit_rate = test_cache_scenario(*cache, access_pattern);
-                results.push_back({"Periodic(" + std::to_string(period) + ")", cache_size, cache_pair.first, hit_rate});
-                delete cache;
+                auto cache = cache_pair.second(cache_size);
+                auto source = make_stream(pattern, PATTERN_LENGTH);
+                run("Periodic(" + std::to_string(period) + ")", cache_size, cache_pair.first, *cache, source);
+            }
+            {
+                auto source = make_stream(pattern, PATTERN_LENGTH);
+                run_optimal("Periodic(" + std::to_string(period) + ")", cache_size, source);
             }
         }
         // 测试 Zipf 分布访问模式
         for (const auto& skew : ZIPF_SKEWS) {
-            std::vector<int> access_pattern = generate_zipfian_access_pattern(DATA_RANGE, PATTERN_LENGTH, skew);
+            ZipfianPattern pattern(DATA_RANGE, skew);
+            for (const auto& cache_pair : cache_factories) {
+                auto cache = cache_pair.second(cache_size);
+                auto source = make_stream(pattern, PATTERN_LENGTH);
+                run("Zipf(" + std::to_string(skew) + ")", cache_size, cache_pair.first, *cache, source);
+            }
+            {
+                auto source = make_stream(pattern, PATTERN_LENGTH);
+                run_optimal("Zipf(" + std::to_string(skew) + ")", cache_size, source);
+            }
+        }
+        // Zipf accesses mixed with one-pass sequential scans
+        for (const auto& scan_length : SCAN_LENGTHS) {
+            ScanMixedPattern pattern(DATA_RANGE, scan_length, SCAN_PERIOD);
             for (const auto& cache_pair : cache_factories) {
-                Cache<int, int>* cache = cache_pair.second(cache_size);
-                double hit_rate = test_cache_scenario(*cache, access_pattern);
-                results.push_back({"Zipf(" + std::to_string(skew) + ")", cache_size, cache_pair.first, hit_rate});
-                delete cache;
+                auto cache = cache_pair.second(cache_size);
+                auto source = make_stream(pattern, PATTERN_LENGTH);
+                run("ScanMixed(" + std::to_string(scan_length) + ")", cache_size, cache_pair.first, *cache, source);
+            }
+            {
+                auto source = make_stream(pattern, PATTERN_LENGTH);
+                run_optimal("ScanMixed(" + std::to_string(scan_length) + ")", cache_size, source);
             }
         }
     }
-    
+    // LIRS at the capacities where it has one LIR slot (2) or none (1)
+    if (trace_path.empty()) {
+        for (int cache_size : {1, 2}) {
+            ZipfianPattern zipf(DATA_RANGE, 1.0);
+            LocalityPattern locality(DATA_RANGE, 10);
+            {
+                LIRSCache<int, int> cache(cache_size);
+                auto source = make_stream(zipf, PATTERN_LENGTH);
+                run("Zipf(" + std::to_string(1.0) + ")", cache_size, "LIRS", cache, source);
+            }
+            {
+                LIRSCache<int, int> cache(cache_size);
+                auto source = make_stream(locality, PATTERN_LENGTH);
+                run("Locality(10)", cache_size, "LIRS", cache, source);
+            }
+        }
+    }
+
     // 输出结果
     std::cout << std::fixed << std::setprecision(4);
     std::cout << "Cache Performance Results:\n";
@@ -166,6 +270,95 @@ int main() {
                   << result.cache_type << "\t\t"
                   << result.hit_rate * 100 << "%\n";
     }
+
+    // Capacity changes in the middle of a Zipf(1.0) workload
+    {
+        const std::vector<size_t> capacities = {200, 50, 200, 100};
+        ZipfianPattern pattern(DATA_RANGE, 1.0);
+        std::vector<std::pair<std::string, std::vector<ResizePhase>>> resize_results = {
+            {"ARC", test_resize_scenario<ARCache<int, int>>(capacities, pattern, PATTERN_LENGTH)},
+            {"LRU", test_resize_scenario<LRUCache<int, int>>(capacities, pattern, PATTERN_LENGTH)},
+            {"LFU", test_resize_scenario<LFUCache<int, int>>(capacities, pattern, PATTERN_LENGTH)}
+        };
+        std::cout << "\nResize Results (Zipf(1.0), " << PATTERN_LENGTH << " accesses per phase):\n";
+        std::cout << "Cache Type\tCapacity\tResized (%)\tCold (%)\tSize After\n";
+        for (const auto& result : resize_results) {
+            for (const auto& phase : result.second) {
+                std::cout << result.first << "\t\t"
+                          << phase.capacity << "\t\t"
+                          << phase.resized_hit_rate * 100 << "%\t"
+                          << phase.cold_hit_rate * 100 << "%\t"
+                          << phase.size_after << "\n";
+            }
+        }
+    }
+
+    // ARC's O(1) clear(), the retired generation freed step by step, and tagged invalidation
+    {
+        const size_t capacity = 200;
+        ZipfianPattern pattern(DATA_RANGE, 1.0);
+        auto stream = make_stream(pattern, PATTERN_LENGTH);
+        std::vector<int> keys = read_all(stream);
+        ARCache<int, int> cache(capacity);
+        VectorSource warm(keys), after(keys);
+        double warm_rate = test_cache_scenario(cache, warm);
+        size_t full_bytes = cache.memory_usage().total();
+        cache.clear();
+        std::cout << "\nClear Results (ARC, capacity " << capacity << ", Zipf(1.0)):\n";
+        std::cout << "Step\t\tSize\tMemory (bytes)\n";
+        std::cout << "Before clear\t" << capacity << "\t" << full_bytes << "\n";
+        std::cout << "After clear\t" << cache.size() << "\t" << cache.memory_usage().total() << "\n";
+        for (int step = 1; cache.reclaim(100); step++) {
+            std::cout << "Reclaim " << step << "\t" << cache.size() << "\t" << cache.memory_usage().total() << "\n";
+        }
+        std::cout << "Reclaimed\t" << cache.size() << "\t" << cache.memory_usage().total() << "\n";
+        double after_rate = test_cache_scenario(cache, after);
+        std::cout << "Hit rate before clear " << warm_rate * 100 << "%, after " << after_rate * 100 << "%\n";
+
+        // 60 keys under tag 1, 60 under tag 2 and 60 untagged; tag 1 is then invalidated
+        ARCache<int, int> tagged(capacity);
+        for (int key = 0; key < 180; key++) {
+            if (key < 120) {
+                tagged.put_tagged(key, key, key < 60 ? 1 : 2);
+            } else {
+                tagged.put(key, key);
+            }
+        }
+        tagged.invalidate_tag(1);
+        std::cout << "\nTag Invalidation Results (ARC, tag 1 of keys 0-59 invalidated):\n";
+        std::cout << "Lookups\t\tHits\tSize After\n";
+        for (int first = 0; first < 180; first += 20) {
+            int hits = 0, value;
+            for (int key = first; key < first + 20; key++) {
+                if (tagged.get(key, value)) hits++;
+            }
+            std::cout << first << "-" << first + 19 << (first < 60 ? " (tag 1)" : first < 120 ? " (tag 2)" : "") << "\t"
+                      << hits << "/20\t" << tagged.size() << "\n";
+        }
+    }
+
+    if (perf) {
+        std::cout << std::setprecision(3);
+        std::cout << "\nHardware counters per access:\nPattern\t\tCache Size\tCache Type";
+        for (int e = 0; e < PerfSample::NUM_EVENTS; e++) {
+            std::cout << "\t" << PerfSample::name(e);
+        }
+        std::cout << "\n";
+        for (const auto& result : results) {
+            std::cout << result.pattern_type << "\t"
+                      << result.cache_size << "\t\t"
+                      << result.cache_type << "\t";
+            for (int e = 0; e < PerfSample::NUM_EVENTS; e++) {
+                std::cout << "\t";
+                if (result.perf.valid[e] && result.accesses) {
+                    std::cout << static_cast<double>(result.perf.value[e]) / result.accesses;
+                } else {
+                    std::cout << "n/a";
+                }
+            }
+            std::cout << "\n";
+        }
+    }
     
     return 0;
 }
\ No newline at end of file
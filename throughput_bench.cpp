@@ -0,0 +1,85 @@
+#include "arc_cache.hpp"
+#include "lru_cache.hpp"
+#include "lfu_cache.hpp"
+#include "s3fifo_cache.hpp"
+#include "sieve_cache.hpp"
+#include "lirs_cache.hpp"
+#include "two_q_cache.hpp"
+#include "slru_cache.hpp"
+#include "lecar_cache.hpp"
+#include "workload.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Hit ratio and single-threaded throughput of each policy on the same pre-generated trace,
+// so key generation is not part of the timed region.
+
+template<typename Pattern>
+std::vector<int> materialize(Pattern pattern, size_t length) {
+    auto source = make_stream(std::move(pattern), length);
+    return read_all(source);
+}
+
+int main(int argc, char** argv) {
+    int data_range = 1000000;
+    int cache_size = 100000;
+    size_t pattern_length = 5000000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            data_range = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            cache_size = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--length") == 0 && i + 1 < argc) {
+            pattern_length = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    std::map<std::string, std::function<std::unique_ptr<Cache<int, int>>(int)>> cache_factories = {
+        {"ARC", [](int size) { return std::make_unique<ARCache<int, int>>(size); }},
+        {"LRU", [](int size) { return std::make_unique<LRUCache<int, int>>(size); }},
+        {"LFU", [](int size) { return std::make_unique<LFUCache<int, int>>(size); }},
+        {"S3FIFO", [](int size) { return std::make_unique<S3FIFOCache<int, int>>(size); }},
+        {"SIEVE", [](int size) { return std::make_unique<SieveCache<int, int>>(size); }},
+        {"LIRS", [](int size) { return std::make_unique<LIRSCache<int, int>>(size); }},
+        {"2Q", [](int size) { return std::make_unique<TwoQCache<int, int>>(size); }},
+        {"SLRU", [](int size) { return std::make_unique<SLRUCache<int, int>>(size); }},
+        {"LeCaR", [](int size) { return std::make_unique<LeCaRCache<int, int>>(size); }}
+    };
+
+    std::vector<std::pair<std::string, std::vector<int>>> traces;
+    traces.emplace_back("Random", materialize(RandomPattern(data_range), pattern_length));
+    traces.emplace_back("Zipf(0.8)", materialize(ZipfianPattern(data_range, 0.8), pattern_length));
+    traces.emplace_back("Zipf(0.99)", materialize(ZipfianPattern(data_range, 0.99), pattern_length));
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Keys: " << data_range << ", cache size: " << cache_size << ", accesses: " << pattern_length << "\n";
+    std::cout << "Pattern\t\tCache Type\tHit Rate (%)\tMops/s\n";
+    for (const auto& trace : traces) {
+        for (const auto& cache_pair : cache_factories) {
+            auto cache = cache_pair.second(cache_size);
+            uint64_t hits = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int key : trace.second) {
+                int value;
+                if (cache->get(key, value)) {
+                    hits++;
+                } else {
+                    cache->put(key, key);
+                }
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << trace.first << "\t" << cache_pair.first << "\t\t"
+                      << 100.0 * hits / trace.second.size() << "%\t\t"
+                      << trace.second.size() / seconds / 1e6 << "\n";
+        }
+    }
+    return 0;
+}
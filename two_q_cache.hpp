@@ -0,0 +1,104 @@
+#ifndef TWO_Q_CACHE_HPP
+#define TWO_Q_CACHE_HPP
+
+#include "lru_cache.hpp"
+#include <algorithm>
+
+// 2Q (Johnson & Shasha, VLDB 1994), full version. New keys enter the FIFO A1in; keys pushed
+// out of A1in are remembered in the ghost FIFO A1out, and only a key seen again while in
+// A1out is admitted to the LRU Am. A one-pass scan therefore never reaches Am.
+// A hit in A1in changes nothing, so most hits write no metadata at all.
+template<typename K, typename V>
+class TwoQCache final : public Cache<K, V> {
+private:
+    struct NoValue {};
+
+    size_t capacity;
+    size_t kin;  // A1in target size, 25% of the capacity
+    size_t kout; // A1out size, 50% of the capacity
+
+    MemoryCounter entry_bytes; // declared before the containers that report to them
+    MemoryCounter index_bytes;
+    MemoryCounter ghost_bytes;
+
+    LRUList<K, V> a1in; // FIFO: never touched on a hit
+    LRUList<K, NoValue> a1out;
+    LRUList<K, V> am;
+
+    void reclaim() {
+        if (a1in.size() + am.size() < capacity) return;
+        if (a1in.size() > kin || am.empty()) {
+            a1out.push_front(a1in.back().first, NoValue());
+            a1in.pop_back();
+            if (a1out.size() > kout) a1out.pop_back();
+        } else {
+            am.pop_back();
+        }
+    }
+
+public:
+    explicit TwoQCache(size_t size)
+        : capacity(size), kin(std::max<size_t>(1, size / 4)), kout(std::max<size_t>(1, size / 2)),
+          a1in(&entry_bytes, &index_bytes), a1out(&ghost_bytes, &ghost_bytes), am(&entry_bytes, &index_bytes) {}
+
+    void put(const K& key, const V& value) override {
+        if (capacity == 0) return;
+
+        auto it = am.find(key);
+        if (it != am.end()) {
+            it->second = value;
+            am.touch(it);
+            return;
+        }
+        it = a1in.find(key);
+        if (it != a1in.end()) {
+            it->second = value;
+            return;
+        }
+
+        reclaim();
+        auto ghost = a1out.find(key);
+        if (ghost != a1out.end()) { // seen recently: hot enough for Am
+            a1out.erase(ghost);
+            am.push_front(key, value);
+        } else {
+            a1in.push_front(key, value);
+        }
+    }
+
+    bool get(const K& key, V& value) override {
+        auto it = am.find(key);
+        if (it != am.end()) {
+            value = it->second;
+            am.touch(it);
+            return true;
+        }
+        it = a1in.find(key);
+        if (it != a1in.end()) {
+            value = it->second;
+            return true;
+        }
+        return false;
+    }
+
+    size_t size() const override {
+        return a1in.size() + am.size();
+    }
+
+    void clear() override {
+        a1in.clear();
+        a1out.clear();
+        am.clear();
+    }
+
+    MemoryUsage memory_usage() const override {
+        MemoryUsage usage;
+        usage.entries = entry_bytes.bytes;
+        usage.ghosts = ghost_bytes.bytes;
+        usage.index = index_bytes.bytes;
+        usage.allocator_overhead = entry_bytes.overhead + ghost_bytes.overhead + index_bytes.overhead;
+        return usage;
+    }
+};
+
+#endif // TWO_Q_CACHE_HPP
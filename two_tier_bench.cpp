@@ -0,0 +1,126 @@
+#include "arc_cache.hpp"
+#include "two_tier_cache.hpp"
+#include "workload.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Zipf trace over more keys than the memory tier holds: hit ratio of ARC in memory alone
+// versus ARC in memory over the log-structured disk tier, with get() latency split by the
+// tier that answered. Values are strings derived from the key and checked on every hit.
+
+std::string value_for(int key, size_t size) {
+    std::string value(size, '\0');
+    for (size_t i = 0; i < size; i++) value[i] = static_cast<char>('a' + (key + i) % 26);
+    return value;
+}
+
+struct Latencies {
+    std::vector<double> samples; // microseconds
+
+    void print(const std::string& name, size_t accesses) {
+        std::cout << name << "\t" << 100.0 * samples.size() / accesses << "%\t\t";
+        if (samples.empty()) {
+            std::cout << "-\t-\t-\n";
+            return;
+        }
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for (double sample : samples) sum += sample;
+        std::cout << sum / samples.size() << "\t"
+                  << samples[samples.size() / 2] << "\t"
+                  << samples[std::min(samples.size() - 1, samples.size() * 99 / 100)] << "\n";
+    }
+};
+
+int main(int argc, char** argv) {
+    int data_range = 1000000;
+    size_t memory_capacity = 50000;
+    size_t disk_capacity = 500000;
+    size_t pattern_length = 2000000;
+    size_t value_size = 256;
+    std::string path = "/tmp/two_tier_bench.log";
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            data_range = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            memory_capacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--disk") == 0 && i + 1 < argc) {
+            disk_capacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--length") == 0 && i + 1 < argc) {
+            pattern_length = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--value-size") == 0 && i + 1 < argc) {
+            value_size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        }
+    }
+
+    auto source = make_stream(ZipfianPattern(data_range, 0.99), pattern_length);
+    std::vector<int> trace = read_all(source);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Keys: " << data_range << ", memory: " << memory_capacity << ", disk: " << disk_capacity
+              << ", value size: " << value_size << ", accesses: " << pattern_length << "\n";
+
+    uint64_t corrupt = 0;
+    {
+        ARCache<int, std::string> memory_only(memory_capacity);
+        uint64_t hits = 0;
+        for (int key : trace) {
+            std::string value;
+            if (memory_only.get(key, value)) {
+                hits++;
+            } else {
+                memory_only.put(key, value_for(key, value_size));
+            }
+        }
+        std::cout << "Memory-only ARC hit rate: " << 100.0 * hits / trace.size() << "%\n\n";
+    }
+
+    try {
+        TwoTierCache<int, std::string> cache(memory_capacity, disk_capacity, path);
+        Latencies memory_hits, disk_hits, misses;
+        auto start = std::chrono::steady_clock::now();
+        for (int key : trace) {
+            std::string value;
+            TwoTierStats before = cache.stats();
+            auto t0 = std::chrono::steady_clock::now();
+            bool hit = cache.get(key, value);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+            if (hit) {
+                if (value != value_for(key, value_size)) corrupt++;
+                (cache.stats().disk_hits > before.disk_hits ? disk_hits : memory_hits).samples.push_back(us);
+            } else {
+                misses.samples.push_back(us);
+                cache.put(key, value_for(key, value_size));
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        TwoTierStats stats = cache.stats();
+        std::cout << "Tier\t\tShare\t\tMean us\tp50 us\tp99 us\n";
+        memory_hits.print("Memory hit", trace.size());
+        disk_hits.print("Disk hit", trace.size());
+        misses.print("Miss\t", trace.size());
+        std::cout << "\nTotal hit rate: " << 100.0 * (stats.memory_hits + stats.disk_hits) / trace.size() << "%, "
+                  << trace.size() / seconds / 1e6 << " Mops/s\n";
+        std::cout << "Spills: " << stats.spills << ", write batches: " << stats.batches
+                  << ", compactions: " << stats.compactions << ", log: " << stats.file_bytes / 1e6
+                  << " MB (" << stats.live_bytes / 1e6 << " MB live)\n";
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    if (corrupt) {
+        std::cerr << corrupt << " hits returned a wrong value\n";
+        return 1;
+    }
+    return 0;
+}
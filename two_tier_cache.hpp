@@ -0,0 +1,430 @@
+#ifndef TWO_TIER_CACHE_HPP
+#define TWO_TIER_CACHE_HPP
+
+#include "arc_cache.hpp"
+#include "serializer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Counters exposed through TwoTierCache::stats()
+struct TwoTierStats {
+    uint64_t memory_hits = 0;
+    uint64_t disk_hits = 0;  // promoted back to memory
+    uint64_t misses = 0;
+    uint64_t spills = 0;     // entries appended to the log
+    uint64_t batches = 0;    // writes issued by the log writer
+    uint64_t compactions = 0;
+    uint64_t file_bytes = 0; // log size, including records not written yet
+    uint64_t live_bytes = 0; // bytes of records still in the index
+};
+
+// Disk tier: an append-only log of records [key size][value size][key][value] with an
+// in-memory index, itself an ARCache over record locations with `capacity` entries. Appends
+// collect in a buffer that a writer thread writes out in batches (when batch_bytes are
+// pending, or every flush_interval); records not written yet are read from the buffers.
+// Overwritten, taken and evicted records are dead space, reclaimed by the writer when they
+// are more than half of a log of at least compact_min_bytes: it copies the live records to
+// a new file a chunk at a time, taking the lock only to check which records of a chunk are
+// still live and, at the end, to swap the file in and repoint the records that were not
+// rewritten meanwhile. Offsets in the index are logical, growing with every append; the file
+// holds the range from `base` on, so records appended during a compaction keep theirs. The
+// file is scratch space: it is truncated on open and removed on destruction. A failed write
+// is rethrown by the next call.
+template<typename K, typename V>
+class LogStore {
+private:
+    struct Location {
+        uint64_t offset;
+        uint32_t size;
+    };
+    static constexpr size_t HEADER = 2 * sizeof(uint32_t);
+    static constexpr size_t CHUNK = 1 << 20;
+
+    std::string path;
+    int fd;
+    size_t batch_bytes;
+    uint64_t compact_min_bytes;
+    std::chrono::milliseconds flush_interval;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake; // to the writer
+    std::condition_variable idle; // from the writer, when `writing` is empty and no compaction runs
+    ARCache<K, Location> index;
+    std::string pending;   // records after `writing`, not handed to the writer yet
+    std::string writing;   // records being written at file_end, without the lock
+    uint64_t base;         // logical offset of the first byte of the file
+    uint64_t file_end;     // logical offset just past the bytes written to the file
+    uint64_t live_bytes;
+    uint64_t spills;
+    uint64_t batches;
+    uint64_t compactions;
+    std::exception_ptr error;
+    bool compacting;       // the writer is copying the file without the lock
+    bool stopping;
+    std::thread writer;
+
+    static std::system_error io_error(const char* what) {
+        return std::system_error(errno, std::generic_category(), what);
+    }
+
+    static void write_all(int file, const char* data, size_t size, uint64_t offset) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = ::pwrite(file, data + done, size - done, static_cast<off_t>(offset + done));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw io_error("log pwrite");
+            }
+            done += static_cast<size_t>(n);
+        }
+    }
+
+    static void read_all(int file, char* data, size_t size, uint64_t offset) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = ::pread(file, data + done, size - done, static_cast<off_t>(offset + done));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw io_error("log pread");
+            }
+            if (n == 0) throw std::runtime_error("log: record past the end of the file");
+            done += static_cast<size_t>(n);
+        }
+    }
+
+    void check_error() const { // with the lock held
+        if (error) std::rethrow_exception(error);
+    }
+
+    uint64_t tail() const {
+        return file_end + writing.size() + pending.size();
+    }
+
+    uint64_t log_size() const {
+        return tail() - base;
+    }
+
+    void read_record(const Location& at, std::string& out) const { // with the lock held
+        out.resize(at.size);
+        if (at.offset >= file_end + writing.size()) {
+            std::memcpy(&out[0], pending.data() + (at.offset - file_end - writing.size()), at.size);
+        } else if (at.offset >= file_end) {
+            std::memcpy(&out[0], writing.data() + (at.offset - file_end), at.size);
+        } else {
+            read_all(fd, &out[0], at.size, at.offset - base);
+        }
+    }
+
+    static void parse(const char* record, uint32_t& key_size, uint32_t& value_size) {
+        std::memcpy(&key_size, record, sizeof(uint32_t));
+        std::memcpy(&value_size, record + sizeof(uint32_t), sizeof(uint32_t));
+    }
+
+    bool discard(const K& key) { // with the lock held
+        Location* at = index.peek(key);
+        if (!at) return false;
+        live_bytes -= at->size;
+        index.erase(key);
+        return true;
+    }
+
+    bool needs_compaction() const {
+        uint64_t total = log_size();
+        return total >= compact_min_bytes && (total - live_bytes) * 2 > total;
+    }
+
+    // Copies the live records to a new file and swaps it in. Called by the writer with the lock
+    // held; it releases the lock while reading and writing, and nothing else writes the file
+    // meanwhile. Appends go on collecting in pending, past file_end.
+    void compact(std::unique_lock<std::mutex>& lock) {
+        struct Record {
+            K key;
+            size_t pos;  // in `in`
+            size_t size;
+            bool live;
+        };
+        struct Move {
+            K key;
+            uint64_t from; // logical offset in the old file
+            uint64_t to;   // offset in the new file
+        };
+
+        uint64_t start = base, end = file_end;
+        std::string compact_path = path + ".compact";
+        int out = ::open(compact_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (out < 0) throw io_error("open compacted log");
+        compacting = true;
+        std::vector<Move> moves;
+        uint64_t out_end = 0;
+        try {
+            lock.unlock();
+            std::string in, copied;
+            std::vector<Record> records;
+            uint64_t in_at = start; // logical offset of in[0]
+            while (in_at < end) {
+                size_t have = in.size();
+                size_t want = static_cast<size_t>(std::min<uint64_t>(CHUNK, end - in_at - have));
+                in.resize(have + want);
+                read_all(fd, &in[have], want, in_at + have - start);
+
+                records.clear();
+                size_t pos = 0;
+                while (in.size() - pos >= HEADER) {
+                    uint32_t key_size, value_size;
+                    parse(in.data() + pos, key_size, value_size);
+                    size_t size = HEADER + key_size + value_size;
+                    if (in.size() - pos < size) break; // continues in the next chunk
+                    records.push_back({Serializer<K>::read(in.data() + pos + HEADER, key_size), pos, size, false});
+                    pos += size;
+                }
+                if (want == 0 && pos < in.size()) throw std::runtime_error("log: truncated record");
+
+                lock.lock();
+                for (Record& record : records) {
+                    Location* at = index.peek(record.key);
+                    record.live = at && at->offset == in_at + record.pos;
+                }
+                lock.unlock();
+
+                for (Record& record : records) {
+                    if (!record.live) continue;
+                    moves.push_back({std::move(record.key), in_at + record.pos, out_end + copied.size()});
+                    copied.append(in, record.pos, record.size);
+                }
+                write_all(out, copied.data(), copied.size(), out_end);
+                out_end += copied.size();
+                copied.clear();
+                in.erase(0, pos);
+                in_at += pos;
+            }
+
+            lock.lock();
+            if (::rename(compact_path.c_str(), path.c_str()) != 0) throw io_error("rename compacted log");
+        } catch (...) {
+            if (!lock.owns_lock()) lock.lock();
+            ::close(out);
+            ::unlink(compact_path.c_str());
+            compacting = false;
+            throw;
+        }
+        ::close(fd);
+        fd = out;
+        base = end - out_end; // the old file_end now falls just past the copied records
+        for (const Move& move : moves) {
+            Location* at = index.peek(move.key);
+            if (at && at->offset == move.from) at->offset = base + move.to; // otherwise dropped or rewritten meanwhile
+        }
+        compacting = false;
+        compactions++;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait_for(lock, flush_interval, [this] { return stopping || pending.size() >= batch_bytes; });
+            if (!pending.empty() && !error) {
+                writing.swap(pending);
+                uint64_t at = file_end - base;
+                lock.unlock();
+                std::exception_ptr failure;
+                try {
+                    write_all(fd, writing.data(), writing.size(), at);
+                } catch (...) {
+                    failure = std::current_exception();
+                }
+                lock.lock();
+                file_end += writing.size();
+                writing.clear();
+                batches++;
+                error = failure;
+                if (!error && needs_compaction()) {
+                    try {
+                        compact(lock);
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                }
+                idle.notify_all();
+            }
+            if (stopping) return;
+        }
+    }
+
+public:
+    LogStore(const std::string& path, size_t capacity, size_t batch_bytes = 1 << 20,
+             uint64_t compact_min_bytes = 4 << 20, std::chrono::milliseconds flush_interval = std::chrono::milliseconds(10))
+        : path(path), fd(::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)),
+          batch_bytes(batch_bytes), compact_min_bytes(compact_min_bytes), flush_interval(flush_interval),
+          index(capacity), base(0), file_end(0), live_bytes(0), spills(0), batches(0), compactions(0),
+          compacting(false), stopping(false) {
+        if (fd < 0) throw io_error("open log");
+        index.set_eviction_callback([this](const K&, const Location& at) { live_bytes -= at.size; });
+        writer = std::thread(&LogStore::run, this);
+    }
+
+    ~LogStore() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+        ::close(fd);
+        ::unlink(path.c_str());
+    }
+
+    LogStore(const LogStore&) = delete;
+    LogStore& operator=(const LogStore&) = delete;
+
+    void put(const K& key, const V& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        check_error();
+        discard(key);
+        size_t start = pending.size();
+        pending.resize(start + HEADER);
+        Serializer<K>::write(key, pending);
+        uint32_t key_size = static_cast<uint32_t>(pending.size() - start - HEADER);
+        Serializer<V>::write(value, pending);
+        uint32_t value_size = static_cast<uint32_t>(pending.size() - start - HEADER - key_size);
+        std::memcpy(&pending[start], &key_size, sizeof(uint32_t));
+        std::memcpy(&pending[start + sizeof(uint32_t)], &value_size, sizeof(uint32_t));
+
+        Location at{file_end + writing.size() + start, static_cast<uint32_t>(pending.size() - start)};
+        live_bytes += at.size;
+        index.put(key, at);
+        spills++;
+        if (pending.size() >= batch_bytes) wake.notify_one();
+    }
+
+    // Moves the value out of the log: returns it and drops the record
+    bool take(const K& key, V& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        check_error();
+        Location* at = index.peek(key);
+        if (!at) return false;
+        std::string record;
+        read_record(*at, record);
+        uint32_t key_size, value_size;
+        parse(record.data(), key_size, value_size);
+        value = Serializer<V>::read(record.data() + HEADER + key_size, value_size);
+        discard(key);
+        return true;
+    }
+
+    bool erase(const K& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return discard(key);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return index.size();
+    }
+
+    void clear() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return writing.empty() && !compacting; });
+        index.clear();
+        pending.clear();
+        if (::ftruncate(fd, 0) != 0) throw io_error("truncate log");
+        base = 0;
+        file_end = 0;
+        live_bytes = 0;
+        spills = 0;
+        batches = 0;
+        compactions = 0;
+        error = nullptr;
+    }
+
+    void add_stats(TwoTierStats& stats) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.spills = spills;
+        stats.batches = batches;
+        stats.compactions = compactions;
+        stats.file_bytes = log_size();
+        stats.live_bytes = live_bytes;
+    }
+
+    MemoryUsage memory_usage() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        MemoryUsage usage = index.memory_usage();
+        usage.entries += pending.capacity() + writing.capacity();
+        return usage;
+    }
+};
+
+// ARC in memory over a LogStore on local disk. Entries that ARC replacement pushes out of
+// T1/T2 are appended to the log; a miss in memory looks in the log, and a hit there moves the
+// entry back into memory, where it lands in T2 if memory's ghosts still remember it. put()
+// drops any copy in the log, so each key lives in at most one tier. Like ARCache it is not
+// thread-safe; only the log's writer runs in the background.
+template<typename K, typename V>
+class TwoTierCache final : public Cache<K, V> {
+private:
+    ARCache<K, V> memory;
+    LogStore<K, V> disk;
+    TwoTierStats counters;
+
+public:
+    TwoTierCache(size_t memory_capacity, size_t disk_capacity, const std::string& path, size_t batch_bytes = 1 << 20)
+        : memory(memory_capacity), disk(path, disk_capacity, batch_bytes) {
+        memory.set_eviction_callback([this](const K& key, const V& value) { disk.put(key, value); });
+    }
+
+    void put(const K& key, const V& value) override {
+        disk.erase(key);
+        memory.put(key, value);
+    }
+
+    bool get(const K& key, V& value) override {
+        if (memory.get(key, value)) {
+            counters.memory_hits++;
+            return true;
+        }
+        if (disk.take(key, value)) {
+            counters.disk_hits++;
+            memory.put(key, value);
+            return true;
+        }
+        counters.misses++;
+        return false;
+    }
+
+    size_t size() const override {
+        return memory.size() + disk.size();
+    }
+
+    void clear() override {
+        memory.clear();
+        disk.clear();
+        counters = TwoTierStats();
+    }
+
+    TwoTierStats stats() const {
+        TwoTierStats stats = counters;
+        disk.add_stats(stats);
+        return stats;
+    }
+
+    MemoryUsage memory_usage() const override {
+        MemoryUsage usage = memory.memory_usage();
+        usage += disk.memory_usage();
+        return usage;
+    }
+};
+
+#endif // TWO_TIER_CACHE_HPP
@@ -0,0 +1,360 @@
+#ifndef WORKLOAD_HPP
+#define WORKLOAD_HPP
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Counter-based random numbers: the value for (counter, lane) is a pure function
+// of the seed, so any slice of a pattern can be generated independently and in any order.
+class CounterRng {
+private:
+    uint64_t seed;
+
+    static uint64_t mix(uint64_t z) { // splitmix64 finalizer
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+public:
+    explicit CounterRng(uint64_t seed = 42) : seed(mix(seed + 0x9e3779b97f4a7c15ULL)) {}
+
+    uint64_t operator()(uint64_t counter, uint64_t lane = 0) const {
+        return mix(seed ^ mix(counter * 0x9e3779b97f4a7c15ULL + lane));
+    }
+
+    double uniform(uint64_t counter, uint64_t lane = 0) const { // [0, 1)
+        return static_cast<double>((*this)(counter, lane) >> 11) * 0x1.0p-53;
+    }
+
+    uint64_t below(uint64_t counter, uint64_t lane, uint64_t bound) const { // [0, bound)
+        return static_cast<uint64_t>((static_cast<unsigned __int128>((*this)(counter, lane)) * bound) >> 64);
+    }
+};
+
+// Patterns map an access index to a key; they hold no mutable state.
+
+// Random access pattern
+class RandomPattern {
+private:
+    int data_range;
+    CounterRng rng;
+
+public:
+    explicit RandomPattern(int data_range, uint64_t seed = 42) : data_range(data_range), rng(seed) {}
+
+    int key_at(uint64_t i) const {
+        return static_cast<int>(rng.below(i, 0, data_range));
+    }
+};
+
+// Locality access pattern (sequential access with some randomness)
+class LocalityPattern {
+private:
+    int data_range;
+    int locality_size;
+    CounterRng rng;
+
+public:
+    LocalityPattern(int data_range, int locality_size, uint64_t seed = 42)
+        : data_range(data_range), locality_size(locality_size), rng(seed) {}
+
+    int key_at(uint64_t i) const {
+        int base = static_cast<int>(rng.below(i, 0, data_range - locality_size + 1));
+        return base + static_cast<int>(rng.below(i, 1, locality_size));
+    }
+};
+
+// Periodic access pattern
+class PeriodicPattern {
+private:
+    int data_range;
+    int period;
+
+public:
+    PeriodicPattern(int data_range, int period) : data_range(data_range), period(period) {}
+
+    int key_at(uint64_t i) const {
+        return static_cast<int>((i % period) % data_range);
+    }
+};
+
+// Zipfian access pattern, sampled by rejection-inversion (Hormann & Derflinger, 1996):
+// O(1) time per key and no table, for any skew >= 0 (skew 1.0 included).
+class ZipfianPattern {
+private:
+    double n;       // number of keys
+    double skew;
+    double h_integral_x1;
+    double h_integral_n;
+    double s;
+    CounterRng rng;
+
+    // log1p(x) / x and expm1(x) / x, with Taylor expansions near 0 where they lose precision
+    static double helper1(double x) {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+    static double helper2(double x) {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+    }
+
+    double h(double x) const { return std::exp(-skew * std::log(x)); }
+
+    double h_integral(double x) const {
+        double log_x = std::log(x);
+        return helper2((1.0 - skew) * log_x) * log_x;
+    }
+
+    double h_integral_inverse(double x) const {
+        double t = std::max(-1.0, x * (1.0 - skew));
+        return std::exp(helper1(t) * x);
+    }
+
+    double draw(uint64_t i, uint64_t attempt) const {
+        return h_integral_n + rng.uniform(i, attempt) * (h_integral_x1 - h_integral_n);
+    }
+
+    double clamp_rank(double x) const { return std::min(n, std::max(1.0, std::floor(x + 0.5))); }
+
+    bool accept(double k, double x, double u) const {
+        return k - x <= s || u >= h_integral(k + 0.5) - h(k);
+    }
+
+public:
+    ZipfianPattern(int data_range, double skew, uint64_t seed = 42)
+        : n(data_range), skew(skew), rng(seed) {
+        if (data_range < 1 || skew < 0.0) throw std::invalid_argument("zipf needs data_range >= 1 and skew >= 0");
+        h_integral_x1 = h_integral(1.5) - 1.0;
+        h_integral_n = h_integral(n + 0.5);
+        s = 2.0 - h_integral_inverse(h_integral(2.5) - h(2.0));
+    }
+
+    int key_at(uint64_t i) const {
+        for (uint64_t attempt = 0;; attempt++) {
+            double u = draw(i, attempt);
+            double x = h_integral_inverse(u);
+            double k = clamp_rank(x);
+            if (accept(k, x, u)) return static_cast<int>(k) - 1; // 索引从 0 开始
+        }
+    }
+
+    // Batch mode: the first attempt for every slot runs as straight-line loops over arrays,
+    // which the compiler can vectorize (log/exp included with -O3 -ffast-math and glibc's
+    // libmvec); the rare rejected slots are redone one by one. Matches key_at exactly.
+    void fill(uint64_t first, int* out, size_t count) const {
+        const size_t CHUNK = 256;
+        double u[CHUNK], x[CHUNK], k[CHUNK];
+        for (size_t base = 0; base < count; base += CHUNK) {
+            size_t m = std::min(CHUNK, count - base);
+            for (size_t j = 0; j < m; j++) u[j] = draw(first + base + j, 0);
+            for (size_t j = 0; j < m; j++) {
+                double t = std::max(-1.0, u[j] * (1.0 - skew));
+                x[j] = std::exp(helper1(t) * u[j]);
+            }
+            for (size_t j = 0; j < m; j++) {
+                k[j] = clamp_rank(x[j]);
+                out[base + j] = static_cast<int>(k[j]) - 1;
+            }
+            for (size_t j = 0; j < m; j++) {
+                if (k[j] - x[j] > s && !accept(k[j], x[j], u[j])) out[base + j] = key_at(first + base + j);
+            }
+        }
+    }
+};
+
+// Zipfian accesses to keys [0, data_range) interrupted by sequential scans: the last
+// scan_length accesses of every period walk consecutive keys from data_range up, each scan
+// continuing where the previous one stopped, so a scanned key is never accessed again (the
+// counter only wraps past INT_MAX).
+class ScanMixedPattern {
+private:
+    int data_range;
+    int scan_length;
+    int period;
+    ZipfianPattern hot;
+
+public:
+    ScanMixedPattern(int data_range, int scan_length, int period, double skew = 1.0, uint64_t seed = 42)
+        : data_range(data_range), scan_length(scan_length), period(period), hot(data_range, skew, seed) {
+        if (scan_length < 0 || period <= scan_length) throw std::invalid_argument("scan-mixed needs 0 <= scan_length < period");
+    }
+
+    int key_at(uint64_t i) const {
+        uint64_t pos = i % period;
+        uint64_t hot_length = period - scan_length;
+        if (pos < hot_length) return hot.key_at(i);
+        uint64_t scanned = (i / period) * scan_length + (pos - hot_length);
+        return data_range + static_cast<int>(scanned % static_cast<uint64_t>(INT_MAX - data_range));
+    }
+};
+
+// Patterns that provide fill(first, out, count) produce whole blocks at once
+template<typename Pattern, typename = void>
+struct has_batch_fill : std::false_type {};
+template<typename Pattern>
+struct has_batch_fill<Pattern, std::void_t<decltype(std::declval<const Pattern&>().fill(uint64_t(), static_cast<int*>(nullptr), size_t()))>>
+    : std::true_type {};
+
+// A source of keys produced in blocks on demand, so a pattern never has to fit in memory.
+class AccessSource {
+public:
+    virtual ~AccessSource() = default;
+    // Writes up to max keys to out and returns how many were written; 0 means exhausted.
+    virtual size_t next_block(int* out, size_t max) = 0;
+};
+
+const size_t ACCESS_BLOCK_SIZE = 4096;
+
+template<typename Pattern>
+class PatternStream : public AccessSource {
+private:
+    Pattern pattern;
+    uint64_t next; // index of the next access to produce
+    uint64_t end;
+
+public:
+    PatternStream(Pattern pattern, uint64_t length) : PatternStream(std::move(pattern), 0, length) {}
+    PatternStream(Pattern pattern, uint64_t begin, uint64_t end)
+        : pattern(std::move(pattern)), next(begin), end(end) {}
+
+    size_t next_block(int* out, size_t max) override {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(max, end - next));
+        if constexpr (has_batch_fill<Pattern>::value) {
+            pattern.fill(next, out, n);
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                out[i] = pattern.key_at(next + i);
+            }
+        }
+        next += n;
+        return n;
+    }
+
+    // Slice `part` of `parts` contiguous slices of the remaining accesses. Concatenated in
+    // order the slices reproduce this stream exactly, so they can be consumed in parallel.
+    PatternStream split(size_t parts, size_t part) const {
+        uint64_t length = end - next;
+        uint64_t lo = next + length / parts * part + std::min<uint64_t>(part, length % parts);
+        uint64_t hi = lo + length / parts + (part < length % parts ? 1 : 0);
+        return PatternStream(pattern, lo, hi);
+    }
+
+    uint64_t remaining() const { return end - next; }
+};
+
+template<typename Pattern>
+PatternStream<Pattern> make_stream(Pattern pattern, uint64_t length) {
+    return PatternStream<Pattern>(std::move(pattern), length);
+}
+
+// Replays keys held in memory
+class VectorSource : public AccessSource {
+private:
+    const std::vector<int>& keys;
+    size_t next = 0;
+
+public:
+    explicit VectorSource(const std::vector<int>& keys) : keys(keys) {}
+
+    size_t next_block(int* out, size_t max) override {
+        size_t n = std::min(max, keys.size() - next);
+        std::copy(keys.begin() + next, keys.begin() + next + n, out);
+        next += n;
+        return n;
+    }
+};
+
+// Drains a source into memory, for consumers that need the whole trace up front (e.g. the MIN oracle)
+inline std::vector<int> read_all(AccessSource& source) {
+    std::vector<int> keys;
+    std::vector<int> block(ACCESS_BLOCK_SIZE);
+    while (size_t n = source.next_block(block.data(), block.size())) {
+        keys.insert(keys.end(), block.begin(), block.begin() + n);
+    }
+    return keys;
+}
+
+// Parses one trace line: either "key" or "timestamp key" (timestamp in seconds, may be
+// fractional). Returns the number of fields read, 0 for blank and malformed lines, which
+// readers skip.
+inline int parse_trace_line(const std::string& line, int& key, double* timestamp = nullptr) {
+    std::istringstream fields(line);
+    double first;
+    if (!(fields >> first)) return 0;
+    long long second;
+    if (!(fields >> second)) {
+        key = static_cast<int>(first);
+        return 1;
+    }
+    if (timestamp) *timestamp = first;
+    key = static_cast<int>(second);
+    return 2;
+}
+
+// Replays a trace file holding one integer key per line, optionally preceded by a timestamp
+// (which is ignored here; see read_timed_trace).
+class TraceFileSource : public AccessSource {
+private:
+    std::ifstream in;
+
+public:
+    explicit TraceFileSource(const std::string& path) : in(path) {
+        if (!in) throw std::runtime_error("cannot open trace file: " + path);
+    }
+
+    size_t next_block(int* out, size_t max) override {
+        size_t n = 0;
+        std::string line;
+        while (n < max && std::getline(in, line)) {
+            if (parse_trace_line(line, out[n])) n++;
+        }
+        return n;
+    }
+};
+
+// A whole trace with the time of each access in seconds from the first one; times is empty
+// when the file carries no timestamps.
+struct TimedTrace {
+    std::vector<int> keys;
+    std::vector<double> times;
+};
+
+inline TimedTrace read_timed_trace(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open trace file: " + path);
+    TimedTrace trace;
+    bool timed = true;
+    std::string line;
+    while (std::getline(in, line)) {
+        int key;
+        double timestamp = 0.0;
+        int fields = parse_trace_line(line, key, &timestamp);
+        if (fields == 0) continue;
+        trace.keys.push_back(key);
+        if (fields == 1) timed = false;
+        if (timed) trace.times.push_back(timestamp);
+    }
+    if (!timed || trace.times.empty()) {
+        trace.times.clear();
+        return trace;
+    }
+    double origin = trace.times.front();
+    for (double& time : trace.times) time -= origin;
+    if (!std::is_sorted(trace.times.begin(), trace.times.end())) {
+        throw std::runtime_error("trace timestamps are not in order: " + path);
+    }
+    return trace;
+}
+
+#endif // WORKLOAD_HPP